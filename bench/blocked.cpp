@@ -0,0 +1,76 @@
+///----------------------------------------------------------------------------------------------------
+/// Blocked scanning benchmark
+/// 	Resolves many signatures over a buffer larger than the last level cache, once with one
+/// 	FallbackScan::Scan per signature and once with a single ScanBlocked pass.
+///
+/// 	g++ -std=c++17 -O2 -I.. blocked.cpp -o blocked -pthread
+/// 	./blocked [signatures] [megabytes]
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using memtools::PBYTE;
+
+int main(int argc, char** argv)
+{
+	uint64_t count     = argc > 1 ? strtoull(argv[1], nullptr, 0) : 64;
+	uint64_t megabytes = argc > 2 ? strtoull(argv[2], nullptr, 0) : 256;
+
+	std::mt19937_64 rng(1);
+
+	std::vector<uint8_t> buffer(megabytes << 20);
+
+	for (uint8_t& b : buffer) { b = (uint8_t)rng(); }
+
+	std::vector<std::pair<PBYTE, uint64_t>> regions{ { buffer.data(), buffer.size() } };
+
+	/* Signatures planted near the end, so both passes read the whole buffer. */
+	std::vector<memtools::FallbackScan> scans;
+
+	for (uint64_t i = 0; i < count; i++)
+	{
+		memtools::Byte bytes[12];
+		uint64_t       offset = buffer.size() - 4096 - (rng() % (buffer.size() / 64));
+
+		for (uint64_t k = 0; k < 12; k++)
+		{
+			bytes[k] = memtools::Byte{ false, (uint8_t)rng() };
+			buffer[offset + k] = bytes[k].Value;
+		}
+
+		scans.push_back(memtools::FallbackScan{ memtools::PatternScan(memtools::Pattern(bytes, 12)) });
+	}
+
+	std::vector<const memtools::FallbackScan*> pointers;
+
+	for (const memtools::FallbackScan& scan : scans) { pointers.push_back(&scan); }
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<void*> separate;
+
+	for (const memtools::FallbackScan& scan : scans) { separate.push_back(scan.Scan(regions)); }
+
+	auto middle = std::chrono::steady_clock::now();
+
+	std::vector<void*> blocked = memtools::ScanBlocked(pointers, regions);
+
+	auto end = std::chrono::steady_clock::now();
+
+	double separateMs = std::chrono::duration<double, std::milli>(middle - start).count();
+	double blockedMs  = std::chrono::duration<double, std::milli>(end - middle).count();
+
+	printf("%llu signatures over %llu MiB, block size %u KiB\n", (unsigned long long)count, (unsigned long long)megabytes, (unsigned)(SCAN_BLOCK_SIZE / 1024));
+	printf("per scan  %10.1f ms\n", separateMs);
+	printf("blocked   %10.1f ms\n", blockedMs);
+	printf("speedup   %10.2fx\n", separateMs / blockedMs);
+
+	if (separate != blocked) { printf("Results differ.\n"); return 1; }
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+///----------------------------------------------------------------------------------------------------
+/// Runtime parsing benchmark
+/// 	Parse throughput of ParsePattern for each accepted style, next to the throwing
+/// 	Pattern(const char*) constructor evaluated at runtime.
+///
+/// 	g++ -std=c++17 -O2 -I.. parse.cpp -o parse
+/// 	./parse [patterns] [rounds]
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char s_Hex[] = "0123456789ABCDEF";
+
+///----------------------------------------------------------------------------------------------------
+/// Generate:
+/// 	Returns signatures of 8 to 48 bytes with a quarter of wildcards, in the given style.
+///----------------------------------------------------------------------------------------------------
+static std::vector<std::string> Generate(uint64_t aCount, int aStyle, std::mt19937& aRng)
+{
+	std::vector<std::string> patterns;
+
+	for (uint64_t n = 0; n < aCount; n++)
+	{
+		uint64_t    length = 8 + aRng() % 41;
+		std::string text;
+		std::string mask;
+
+		for (uint64_t i = 0; i < length; i++)
+		{
+			bool    wildcard = i > 0 && aRng() % 4 == 0;
+			uint8_t value    = (uint8_t)aRng();
+
+			switch (aStyle)
+			{
+				case 0: /* IDA */
+					if (i > 0) { text += ' '; }
+					if (wildcard) { text += '?'; } else { text += s_Hex[value >> 4]; text += s_Hex[value & 15]; }
+					break;
+				case 1: /* x64dbg, unseparated */
+					if (wildcard) { text += "??"; } else { text += s_Hex[value >> 4]; text += s_Hex[value & 15]; }
+					break;
+				case 2: /* nibbles and bitmasks */
+					if (i > 0) { text += ' '; }
+					text += wildcard ? '?' : s_Hex[value >> 4];
+					text += s_Hex[value & 15];
+					if (i % 8 == 7) { text += "&F8"; }
+					break;
+				default: /* code-style with mask */
+					text += "\\x";
+					text += s_Hex[value >> 4];
+					text += s_Hex[value & 15];
+					mask += wildcard ? '?' : 'x';
+					break;
+			}
+		}
+
+		if (aStyle == 3) { text += ' '; text += mask; }
+
+		patterns.push_back(text);
+	}
+
+	return patterns;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t count  = argc > 1 ? strtoull(argv[1], nullptr, 0) : 10000;
+	uint64_t rounds = argc > 2 ? strtoull(argv[2], nullptr, 0) : 20;
+
+	static const char* s_Styles[] = { "IDA", "x64dbg", "nibbles/masks", "code-style" };
+
+	std::mt19937 rng(1);
+
+	printf("%-16s %14s %10s\n", "style", "patterns/s", "MB/s");
+
+	for (int style = 0; style < 4; style++)
+	{
+		std::vector<std::string> patterns = Generate(count, style, rng);
+
+		uint64_t bytes  = 0;
+		uint64_t failed = 0;
+
+		for (const std::string& text : patterns) { bytes += text.size(); }
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint64_t r = 0; r < rounds; r++)
+		{
+			for (const std::string& text : patterns)
+			{
+				memtools::Pattern pattern;
+
+				if (!memtools::ParsePattern(text, pattern)) { failed++; }
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("%-16s %14.0f %10.1f\n", s_Styles[style], count * rounds / seconds, bytes * rounds / seconds / 1e6);
+
+		if (failed) { printf("%llu patterns failed to parse.\n", (unsigned long long)failed); return 1; }
+	}
+
+	/* The compile-time parser called with runtime strings, for comparison. */
+	std::vector<std::string> patterns = Generate(count, 0, rng);
+
+	uint64_t bytes = 0;
+	uint64_t sizes = 0;
+
+	for (const std::string& text : patterns) { bytes += text.size(); }
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t r = 0; r < rounds; r++)
+	{
+		for (const std::string& text : patterns)
+		{
+			memtools::Pattern pattern(text.c_str());
+			sizes += pattern.Size;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%-16s %14.0f %10.1f\n", "Pattern(char*)", count * rounds / seconds, bytes * rounds / seconds / 1e6);
+
+	return sizes ? 0 : 1;
+}
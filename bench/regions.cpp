@@ -0,0 +1,181 @@
+///----------------------------------------------------------------------------------------------------
+/// Region enumeration benchmark (Linux)
+/// 	Compares the PROCMAP_QUERY ioctl with parsing /proc/self/maps, for a process with 1k, 10k and
+/// 	100k mappings of which few are executable. Sizes above vm.max_map_count fail, raise it with
+/// 	sysctl -w vm.max_map_count=200000 to run them.
+///
+/// 	g++ -std=c++17 -O2 -I.. regions.cpp -o regions -pthread -ldl
+/// 	./regions [iterations]
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using memtools::PBYTE;
+
+template <typename Fn>
+static double TimeUs(uint64_t aIterations, Fn aFn)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t i = 0; i < aIterations; i++) { aFn(); }
+
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / aIterations;
+}
+
+///----------------------------------------------------------------------------------------------------
+/// CountMappings:
+/// 	Returns the number of VMAs of the process, one per line of /proc/self/maps.
+///----------------------------------------------------------------------------------------------------
+static uint64_t CountMappings()
+{
+	uint64_t count = 0;
+
+	if (FILE* file = fopen("/proc/self/maps", "r"))
+	{
+		char   buffer[65536];
+		size_t read;
+
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			for (size_t i = 0; i < read; i++) { count += buffer[i] == '\n'; }
+		}
+
+		fclose(file);
+	}
+
+	return count;
+}
+
+///----------------------------------------------------------------------------------------------------
+/// ReadMaxMapCount:
+/// 	Returns vm.max_map_count, or 0 if it can't be read.
+///----------------------------------------------------------------------------------------------------
+static uint64_t ReadMaxMapCount()
+{
+	unsigned long long value = 0;
+
+	if (FILE* file = fopen("/proc/sys/vm/max_map_count", "r"))
+	{
+		if (fscanf(file, "%llu", &value) != 1) { value = 0; }
+
+		fclose(file);
+	}
+
+	return value;
+}
+
+///----------------------------------------------------------------------------------------------------
+/// Run:
+/// 	Maps aMappings pages as separate VMAs and times both enumerations. Returns false if the
+/// 	mappings couldn't be created or the enumerations disagree.
+///----------------------------------------------------------------------------------------------------
+static bool Run(uint64_t aMappings, uint64_t aIterations, uint64_t aMaxMapCount)
+{
+	uint64_t before = CountMappings();
+
+	if (aMaxMapCount && before + aMappings > aMaxMapCount)
+	{
+		printf("%8llu  needs %llu VMAs, above vm.max_map_count %llu\n", (unsigned long long)aMappings,
+			(unsigned long long)(before + aMappings), (unsigned long long)aMaxMapCount);
+		return false;
+	}
+
+	uint64_t baseline      = 0;
+	auto     countBaseline = [&baseline](PBYTE, uint64_t) { baseline++; return true; };
+
+	memtools::ForEachRegionProcMaps(nullptr, countBaseline, nullptr);
+
+	/* Alternate protections so the kernel can't merge neighbouring mappings, one in eight executable. */
+	uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+	PBYTE    area = (PBYTE)mmap(nullptr, aMappings * page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (area == MAP_FAILED)
+	{
+		printf("%8llu  mmap failed: %s\n", (unsigned long long)aMappings, strerror(errno));
+		return false;
+	}
+
+	for (uint64_t i = 0; i < aMappings; i++)
+	{
+		int protection = i % 8 == 0 ? PROT_READ | PROT_EXEC : i % 2 ? PROT_READ | PROT_WRITE : PROT_READ;
+
+		if (mprotect(area + i * page, page, protection) != 0)
+		{
+			printf("%8llu  mprotect of page %llu failed: %s\n", (unsigned long long)aMappings, (unsigned long long)i, strerror(errno));
+			munmap(area, aMappings * page);
+			return false;
+		}
+	}
+
+	/* The pages at both ends may merge with neighbouring mappings. */
+	uint64_t vmas  = CountMappings();
+	uint64_t added = vmas - before;
+	bool     valid = added + 2 >= aMappings;
+
+	uint64_t expected   = baseline + (aMappings + 7) / 8;
+	uint64_t queryCount = 0;
+	uint64_t mapsCount  = 0;
+
+	auto countQuery = [&queryCount](PBYTE, uint64_t) { queryCount++; return true; };
+	auto countMaps  = [&mapsCount](PBYTE, uint64_t) { mapsCount++; return true; };
+
+	memtools::ForEachRegionProcmapQuery(nullptr, countQuery, nullptr);
+	memtools::ForEachRegionProcMaps(nullptr, countMaps, nullptr);
+
+	valid = valid && queryCount == expected && mapsCount == expected;
+
+	uint64_t queryRegions = queryCount;
+	uint64_t mapsRegions  = mapsCount;
+
+	/* Fewer iterations for the larger sizes, so every size takes about as long. */
+	uint64_t iterations = std::max<uint64_t>(5, aIterations * 1000 / aMappings);
+
+	double query = TimeUs(iterations, [&]() { memtools::ForEachRegionProcmapQuery(nullptr, countQuery, nullptr); });
+	double maps  = TimeUs(iterations, [&]() { memtools::ForEachRegionProcMaps(nullptr, countMaps, nullptr); });
+
+	printf("%8llu  %8llu  %6llu / %-6llu  %16.1f  %7.1f  %6.2fx%s\n", (unsigned long long)aMappings, (unsigned long long)vmas,
+		(unsigned long long)queryRegions, (unsigned long long)mapsRegions, query, maps, maps / query, valid ? "" : "  MISMATCH");
+
+	if (!valid)
+	{
+		printf("          expected %llu executable regions and at least %llu new VMAs, got %llu new VMAs\n",
+			(unsigned long long)expected, (unsigned long long)(aMappings - 2), (unsigned long long)added);
+	}
+
+	munmap(area, aMappings * page);
+
+	return valid;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t iterations  = argc > 1 ? strtoull(argv[1], nullptr, 0) : 200;
+	uint64_t maxMapCount = ReadMaxMapCount();
+
+	auto ignore = [](PBYTE, uint64_t) { return true; };
+
+	if (!memtools::ForEachRegionProcmapQuery(nullptr, ignore, nullptr))
+	{
+		printf("PROCMAP_QUERY is not supported by this kernel.\n");
+		return 1;
+	}
+
+	printf("vm.max_map_count %llu\n", (unsigned long long)maxMapCount);
+	printf("mappings      VMAs  executable regions  PROCMAP_QUERY us  maps us  speedup\n");
+
+	bool success = true;
+
+	for (uint64_t mappings : { 1000ULL, 10000ULL, 100000ULL })
+	{
+		success = Run(mappings, iterations, maxMapCount) && success;
+	}
+
+	return success ? 0 : 1;
+}
@@ -9,23 +9,70 @@
 #ifndef MEMTOOLS_H
 #define MEMTOOLS_H
 
+#ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <link.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <exception>
+#include <functional>
+#include <future>
 #include <initializer_list>
-#include <psapi.h>
+#include <memory>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 /// You can define ENABLE_PATTERN_CACHING which will store the first result matching a given pattern.
 /// This potentially speeds up multiple searches starting with the same pattern.
 //#define ENABLE_PATTERN_CACHING
-#ifdef ENABLE_PATTERN_CACHING
-#include <mutex>
+
+/// Patterns up to PATTERN_INLINE_LENGTH bytes are stored inline and copied with their scan.
+/// Longer patterns have no limit, but refer to their bytes instead, see Pattern.
+#ifndef PATTERN_INLINE_LENGTH
+#define PATTERN_INLINE_LENGTH  32
 #endif
 
-#ifndef MAX_PATTERN_LENGTH
-#define MAX_PATTERN_LENGTH     128
+/// ScanBlocked() runs all patterns over one block of SCAN_BLOCK_SIZE bytes before moving to the next.
+/// It should fit the L2 cache of the target CPU.
+#ifndef SCAN_BLOCK_SIZE
+#define SCAN_BLOCK_SIZE        (256 * 1024)
 #endif
 
 #ifndef MAX_INSTRUCTION_LENGTH
@@ -39,11 +86,46 @@
 #define HEXPOW_1               0x01 /* power of the first digit */
 #define HEXPOW_2               0x10 /* power of the second digit */
 
+/// You can define MEMTOOLS_DISABLE_SIMD to always use the scalar matching loop.
+/// Otherwise the AVX-512BW matcher is selected at runtime, if the CPU and OS support it.
+//#define MEMTOOLS_DISABLE_SIMD
+#if !defined(MEMTOOLS_DISABLE_SIMD) && (defined(_M_X64) || defined(__x86_64__))
+#define MEMTOOLS_HAS_AVX512
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define MEMTOOLS_HAS_COROUTINES
+#endif
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_lib_jthread)
+#include <stop_token>
+#define MEMTOOLS_HAS_STOP_TOKEN
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MEMTOOLS_TARGET_AVX512BW __attribute__((target("avx512f,avx512bw,bmi")))
+#else
+#define MEMTOOLS_TARGET_AVX512BW
+#endif
+
+#if !defined(_MSC_VER) && !defined(__unaligned)
+#define __unaligned
+#endif
+
 ///----------------------------------------------------------------------------------------------------
 /// memtools Namespace
 ///----------------------------------------------------------------------------------------------------
 namespace memtools
 {
+#ifndef _WIN32
+	typedef uint8_t* PBYTE;
+#endif
+
 	///----------------------------------------------------------------------------------------------------
 	/// FollowRelativeAddress:
 	/// 	Follows a relative address.
@@ -76,7 +158,7 @@ namespace memtools
 				/* far jmp */
 				/* x64: address is relative to after jmp */
 				/* x86: absolute address can be read directly */
-#ifdef _WIN64
+#if defined(_WIN64) || defined(__x86_64__)
 				aPointer += 6 + *(__unaligned int32_t*) &aPointer[2]; // jmp [+imm32]
 #else
 				aPointer = *(__unaligned int32_t*) &aPointer[2]; // jmp [imm32]
@@ -95,23 +177,145 @@ namespace memtools
 
 	///----------------------------------------------------------------------------------------------------
 	/// Byte Struct
+	/// 	A memory byte matches a wildcard or if (byte & Mask) == Value. Nibble wildcards like '4?'
+	/// 	have a mask of F0.
 	///----------------------------------------------------------------------------------------------------
 	struct Byte
 	{
-		bool    IsWildcard = false;
-		uint8_t Value      = 0;
+		bool    IsWildcard;
+		uint8_t Value;
+		uint8_t Mask;
+
+		constexpr Byte() : IsWildcard(false), Value(0), Mask(0xFF) {}
+		constexpr Byte(bool aIsWildcard, uint8_t aValue = 0, uint8_t aMask = 0xFF)
+			: IsWildcard(aIsWildcard || aMask == 0)
+			, Value(aIsWildcard ? 0 : (uint8_t)(aValue & aMask))
+			, Mask(aIsWildcard ? 0 : aMask)
+		{
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Matches:
+		/// 	Returns true if the memory byte matches.
+		///----------------------------------------------------------------------------------------------------
+		constexpr bool Matches(uint8_t aByte) const { return this->IsWildcard || (aByte & this->Mask) == this->Value; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsExact:
+		/// 	Returns true if exactly one value matches.
+		///----------------------------------------------------------------------------------------------------
+		constexpr bool IsExact() const { return !this->IsWildcard && this->Mask == 0xFF; }
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// PatternArena Struct
+	/// 	Process-wide append-only storage for the bytes of long runtime patterns. Never freed, so
+	/// 	patterns can be copied freely without owning their bytes.
+	///----------------------------------------------------------------------------------------------------
+	struct PatternArena
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// Store:
+		/// 	Copies the bytes into the arena and returns their stable address.
+		///----------------------------------------------------------------------------------------------------
+		static inline const Byte* Store(const Byte* aBytes, uint64_t aCount)
+		{
+			static constexpr uint64_t CHUNK_BYTES = 4096;
+
+			static std::mutex                           s_Mutex;
+			static std::vector<std::unique_ptr<Byte[]>> s_Chunks;
+			static uint64_t                             s_Used     = 0;
+			static uint64_t                             s_Capacity = 0;
+
+			const std::lock_guard<std::mutex> lock(s_Mutex);
+
+			if (s_Chunks.empty() || s_Used + aCount > s_Capacity)
+			{
+				s_Capacity = std::max<uint64_t>(CHUNK_BYTES, aCount);
+				s_Chunks.emplace_back(new Byte[s_Capacity]);
+				s_Used = 0;
+			}
+
+			Byte* storage = s_Chunks.back().get() + s_Used;
+			std::copy(aBytes, aBytes + aCount, storage);
+			s_Used += aCount;
+
+			return storage;
+		}
 	};
 
+	template <std::size_t N>
+	struct FixedPattern;
+
 	///----------------------------------------------------------------------------------------------------
 	/// Pattern Struct
+	/// 	Up to PATTERN_INLINE_LENGTH bytes are stored inline. Longer patterns refer to their bytes:
+	/// 	in a FixedPattern at compile-time, in the PatternArena at runtime, or in a caller's buffer
+	/// 	for views.
 	///----------------------------------------------------------------------------------------------------
 	struct Pattern
 	{
-		Byte     Bytes[MAX_PATTERN_LENGTH];
-		uint64_t Size;
+		uint64_t    Size;
+		const Byte* External;
+		Byte        Inline[PATTERN_INLINE_LENGTH];
+
+		constexpr Pattern() : Size(0), External(nullptr), Inline() {}
+		inline constexpr Pattern(const char* aPattern) : Size(0), External(nullptr), Inline()
+		{
+			this->Size = Parse(aPattern, this->Inline, PATTERN_INLINE_LENGTH);
+
+			/* Too long to store inline, not possible in constant evaluation. */
+			if (this->Size > PATTERN_INLINE_LENGTH)
+			{
+				this->External = StoreLong(aPattern, this->Size);
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Copies the bytes, to the arena if they don't fit inline.
+		///----------------------------------------------------------------------------------------------------
+		inline Pattern(const Byte* aBytes, uint64_t aSize) : Size(aSize), External(nullptr), Inline()
+		{
+			if (aSize > PATTERN_INLINE_LENGTH)
+			{
+				this->External = PatternArena::Store(aBytes, aSize);
+			}
+			else
+			{
+				std::copy(aBytes, aBytes + aSize, this->Inline);
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Refers to the bytes of a long compile-time pattern. It must have static storage duration.
+		///----------------------------------------------------------------------------------------------------
+		template <std::size_t N>
+		inline constexpr Pattern(const FixedPattern<N>& aPattern);
+
+		///----------------------------------------------------------------------------------------------------
+		/// View:
+		/// 	Refers to the bytes without copying them. They must outlive the pattern.
+		///----------------------------------------------------------------------------------------------------
+		static constexpr Pattern View(const Byte* aBytes, uint64_t aSize)
+		{
+			Pattern result;
+			result.Size     = aSize;
+			result.External = aBytes;
+			return result;
+		}
 
-		constexpr Pattern() : Bytes(), Size(0) {}
-		inline constexpr Pattern(const char* aPattern) : Bytes(), Size(0)
+		constexpr const Byte* Data() const { return this->External ? this->External : this->Inline; }
+
+		constexpr const Byte& operator[](uint64_t aIndex) const { return this->Data()[aIndex]; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// Parse:
+		/// 	Parses the pattern string, writing up to aCapacity bytes to aOut.
+		/// 	Returns the number of bytes in the pattern.
+		///----------------------------------------------------------------------------------------------------
+		static inline constexpr uint64_t Parse(const char* aPattern, Byte* aOut, uint64_t aCapacity)
 		{
 			uint64_t len = 0; /* length of the pattern string */
 
@@ -124,12 +328,6 @@ namespace memtools
 
 			for (uint64_t i = 0; i < len; i++)
 			{
-				/* Pattern string not done, but already filled max byte length. */
-				if (this->Size >= MAX_PATTERN_LENGTH)
-				{
-					break;
-				}
-
 				/* Skip spaces. */
 				if (aPattern[i] == ' ') { continue; }
 
@@ -137,84 +335,133 @@ namespace memtools
 				if (aPattern[i] == '<') { continue; }
 				if (aPattern[i] == '>') { continue; }
 
+				Byte byte{};
+
 				/* Match wildcard. */
 				if (aPattern[i] == '?')
 				{
-					this->Bytes[j] = Byte{ true };
-					this->Size++;
-					j++;
+					byte = Byte{ true };
 
 					/* Match if double wildcard '??' instead of single wildcard '?'. */
 					if (i + 1 < len && aPattern[i + 1] == '?')
 					{
 						i++;
 					}
-
-					continue;
+					/* Match if nibble wildcard '?8'. */
+					else if (i + 1 < len && IsHex(aPattern[i + 1]))
+					{
+						byte = Byte{ false, HexDigit(aPattern[i + 1]), 0x0F };
+						i++;
+					}
 				}
-
 				/* Match hex. */
-				if ((aPattern[i] >= CHAR_0 && aPattern[i] <= CHAR_9) || (aPattern[i] >= CHAR_A && aPattern[i] <= CHAR_F))
+				else if (IsHex(aPattern[i]))
 				{
-					uint8_t val = 0;
-
 					/* Match if double hex 'FF' instead of single hex 'F' */
-					if (i + 1 < len && (aPattern[i + 1] >= CHAR_0 && aPattern[i + 1] <= CHAR_9) || (aPattern[i + 1] >= CHAR_A && aPattern[i + 1] <= CHAR_F))
+					if (i + 1 < len && IsHex(aPattern[i + 1]))
 					{
-						/* Calculate byte value using position.*/
-						if (aPattern[i] <= CHAR_9)
-						{
-							val += (aPattern[i] - CHAR_0) * HEXPOW_2;
-						}
-						else
-						{
-							val += ((aPattern[i] - CHAR_A) + HEXVAL_A) * HEXPOW_2;
-						}
-
-						/* Calculate second hex value part of byte. */
-						if (aPattern[i + 1] <= CHAR_9)
-						{
-							val += (aPattern[i + 1] - CHAR_0) * HEXPOW_1;
-						}
-						else
-						{
-							val += ((aPattern[i + 1] - CHAR_A) + HEXVAL_A) * HEXPOW_1;
-						}
-
+						byte = Byte{ false, (uint8_t)(HexDigit(aPattern[i]) * HEXPOW_2 + HexDigit(aPattern[i + 1]) * HEXPOW_1) };
+						i++;
+					}
+					/* Match if nibble wildcard '4?'. */
+					else if (i + 1 < len && aPattern[i + 1] == '?')
+					{
+						byte = Byte{ false, (uint8_t)(HexDigit(aPattern[i]) * HEXPOW_2), 0xF0 };
 						i++;
 					}
 					else
 					{
 						/* Single hex value. */
-						if (aPattern[i] <= CHAR_9)
-						{
-							val += (aPattern[i] - CHAR_0) * HEXPOW_1;
-						}
-						else
-						{
-							val += ((aPattern[i] - CHAR_A) + HEXVAL_A) * HEXPOW_1;
-						}
+						byte = Byte{ false, (uint8_t)(HexDigit(aPattern[i]) * HEXPOW_1) };
 					}
-
-					this->Bytes[j] = Byte{ false, val };
-					this->Size++;
-					j++;
-
-					continue;
 				}
 				else
 				{
 					throw "Invalid hexadecimal.";
 				}
+
+				/* Match explicit bitmask 'B8&F8'. */
+				if (i + 1 < len && aPattern[i + 1] == '&')
+				{
+					if (i + 3 >= len || !IsHex(aPattern[i + 2]) || !IsHex(aPattern[i + 3]))
+					{
+						throw "Invalid bitmask.";
+					}
+
+					byte = Byte{ byte.IsWildcard, byte.Value, (uint8_t)(byte.Mask & (HexDigit(aPattern[i + 2]) * HEXPOW_2 + HexDigit(aPattern[i + 3]))) };
+					i += 3;
+				}
+
+				if (j < aCapacity)
+				{
+					aOut[j] = byte;
+				}
+				j++;
 			}
+
+			return j;
+		}
+
+	private:
+		static constexpr bool IsHex(char aChar)
+		{
+			return (aChar >= CHAR_0 && aChar <= CHAR_9) || (aChar >= CHAR_A && aChar <= CHAR_F);
+		}
+
+		static constexpr uint8_t HexDigit(char aChar)
+		{
+			return aChar <= CHAR_9 ? (uint8_t)(aChar - CHAR_0) : (uint8_t)((aChar - CHAR_A) + HEXVAL_A);
+		}
+
+		static inline const Byte* StoreLong(const char* aPattern, uint64_t aSize)
+		{
+			std::vector<Byte> bytes(aSize);
+			Parse(aPattern, bytes.data(), aSize);
+
+			return PatternArena::Store(bytes.data(), aSize);
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// FixedPattern Struct
+	/// 	Compile-time pattern sized by its string, for patterns longer than PATTERN_INLINE_LENGTH:
+	/// 	static constexpr memtools::FixedPattern Long("48 8B ...");
+	///----------------------------------------------------------------------------------------------------
+	template <std::size_t N>
+	struct FixedPattern
+	{
+		Byte     Bytes[N];
+		uint64_t Size;
+
+		inline constexpr FixedPattern(const char (&aPattern)[N]) : Bytes(), Size(0)
+		{
+			this->Size = Pattern::Parse(aPattern, this->Bytes, N);
 		}
 	};
 
+	template <std::size_t N>
+	inline constexpr Pattern::Pattern(const FixedPattern<N>& aPattern) : Size(aPattern.Size), External(nullptr), Inline()
+	{
+		if (aPattern.Size > PATTERN_INLINE_LENGTH)
+		{
+			this->External = aPattern.Bytes;
+		}
+		else
+		{
+			for (uint64_t i = 0; i < aPattern.Size; i++)
+			{
+				this->Inline[i] = aPattern.Bytes[i];
+			}
+		}
+	}
+
 	inline bool operator==(const Pattern& lhs, const PBYTE rhs)
 	{
+		const Byte* bytes = lhs.Data();
+
 		for (uint64_t i = 0; i < lhs.Size; i++)
 		{
-			if (!lhs.Bytes[i].IsWildcard && lhs.Bytes[i].Value != rhs[i])
+			if (!bytes[i].Matches(rhs[i]))
 			{
 				return false;
 			}
@@ -225,7 +472,25 @@ namespace memtools
 
 	inline bool operator==(const Pattern& lhs, const Pattern& rhs)
 	{
-		return memcmp(&lhs, &rhs, sizeof(Pattern)) == 0;
+		if (lhs.Size != rhs.Size) { return false; }
+
+		const Byte* lhsBytes = lhs.Data();
+		const Byte* rhsBytes = rhs.Data();
+
+		for (uint64_t i = 0; i < lhs.Size; i++)
+		{
+			if (lhsBytes[i].IsWildcard != rhsBytes[i].IsWildcard)
+			{
+				return false;
+			}
+
+			if (!lhsBytes[i].IsWildcard && (lhsBytes[i].Mask != rhsBytes[i].Mask || lhsBytes[i].Value != rhsBytes[i].Value))
+			{
+				return false;
+			}
+		}
+
+		return true;
 	}
 
 	inline bool operator!=(const Pattern& lhs, const Pattern& rhs)
@@ -234,439 +499,7532 @@ namespace memtools
 	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// EOperation Enumeration
+	/// EParseError Enumeration
 	///----------------------------------------------------------------------------------------------------
-	enum class EOperation
+	enum class EParseError
 	{
-		NONE,
-		offset,
-		follow,
-		strcmp,
-		wcscmp,
-		cmpi8,
-		cmpi16,
-		cmpi32,
-		cmpi64,
-		pushaddr,
-		popaddr,
-		advwcard
+		none,
+		empty,            /* No bytes in the pattern. */
+		invalidCharacter, /* Neither hex, wildcard nor separator. */
+		incompleteByte,   /* Odd number of digits in a token. */
+		invalidMask,      /* Mask character other than 'x' or '?'. */
+		maskLength        /* Mask length differs from the byte count. */
 	};
 
 	///----------------------------------------------------------------------------------------------------
-	/// Instruction Struct
+	/// ParseResult Struct
 	///----------------------------------------------------------------------------------------------------
-	struct Instruction
+	struct ParseResult
 	{
-		EOperation     Operation;
-		int64_t        Value;
-		const char*    String;
-		const wchar_t* WString;
+		EParseError Error    = EParseError::none;
+		uint64_t    Position = 0; /* offset of the offending character in the input */
 
-		constexpr Instruction()                                      : Operation(EOperation::NONE), Value(0),      String(nullptr), WString(nullptr) {}
-		constexpr Instruction(EOperation aOp)                        : Operation(aOp),              Value(0),      String(nullptr), WString(nullptr) {}
-		constexpr Instruction(EOperation aOp, int64_t        aValue) : Operation(aOp),              Value(aValue), String(nullptr), WString(nullptr) {}
-		constexpr Instruction(EOperation aOp, const char*    aStr)   : Operation(aOp),              Value(0),      String(aStr),    WString(nullptr) {}
-		constexpr Instruction(EOperation aOp, const wchar_t* aWStr)  : Operation(aOp),              Value(0),      String(nullptr), WString(aWStr) {}
+		inline explicit operator bool() const { return this->Error == EParseError::none; }
+	};
 
-		inline constexpr Instruction(const Instruction& aOther) 
-			: Operation(aOther.Operation)
-			, Value(aOther.Value)
-			, String(aOther.String)
-			, WString(aOther.WString)
-		{}
+	///----------------------------------------------------------------------------------------------------
+	/// parser Namespace
+	///----------------------------------------------------------------------------------------------------
+	namespace parser
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// HexValue:
+		/// 	Returns the value of a hex digit of either case or -1.
+		///----------------------------------------------------------------------------------------------------
+		constexpr int HexValue(char aChar)
+		{
+			return (aChar >= '0' && aChar <= '9') ? aChar - '0'
+				: (aChar >= 'A' && aChar <= 'F') ? aChar - 'A' + HEXVAL_A
+				: (aChar >= 'a' && aChar <= 'f') ? aChar - 'a' + HEXVAL_A
+				: -1;
+		}
 
-		constexpr inline Instruction& operator=(const Instruction& aOther)
+		///----------------------------------------------------------------------------------------------------
+		/// IsSeparator:
+		/// 	Whitespace, quotes, commas and the significance brackets.
+		///----------------------------------------------------------------------------------------------------
+		constexpr bool IsSeparator(char aChar)
 		{
-			if (this == &aOther) { return *this; }
+			return aChar == ' ' || aChar == '\t' || aChar == '\r' || aChar == '\n' || aChar == ','
+				|| aChar == '"' || aChar == '<' || aChar == '>';
+		}
 
-			this->Operation = aOther.Operation;
-			this->Value = 0;
-			this->String = nullptr;
-			this->WString = nullptr;
+		///----------------------------------------------------------------------------------------------------
+		/// ApplyMask:
+		/// 	Turns the bytes marked '?' or '.' into wildcards.
+		///----------------------------------------------------------------------------------------------------
+		inline ParseResult ApplyMask(std::string_view aMask, uint64_t aMaskOffset, std::vector<Byte>& aBytes)
+		{
+			uint64_t j = 0;
 
-			switch (this->Operation)
+			for (uint64_t i = 0; i < aMask.size(); i++)
 			{
-				case EOperation::strcmp:
+				char c = aMask[i];
+
+				if (IsSeparator(c)) { continue; }
+
+				if (c != 'x' && c != 'X' && c != '?' && c != '.')
 				{
-					this->String = aOther.String;
-					break;
+					return ParseResult{ EParseError::invalidMask, aMaskOffset + i };
 				}
-				case EOperation::wcscmp:
+
+				if (j >= aBytes.size())
 				{
-					this->WString = aOther.WString;
-					break;
+					return ParseResult{ EParseError::maskLength, aMaskOffset + i };
 				}
-				default:
+
+				if (c == '?' || c == '.')
 				{
-					this->Value = aOther.Value;
-					break;
+					aBytes[j] = Byte{ true };
 				}
+
+				j++;
 			}
 
-			return *this;
-		}
-	};
+			if (j != aBytes.size())
+			{
+				return ParseResult{ EParseError::maskLength, aMaskOffset + aMask.size() };
+			}
 
-	///----------------------------------------------------------------------------------------------------
-	/// Offset:
-	/// 	Adds an offset (in bytes) to the current memory address.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction Offset(int64_t aValue) { return Instruction(EOperation::offset, aValue); }
-	
-	///----------------------------------------------------------------------------------------------------
-	/// Follow:
-	/// 	Interprets the current address as a relative address and follows it.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction Follow() { return Instruction(EOperation::follow); }
+			return ParseResult{};
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ParseEscaped:
+		/// 	Parses code-style "\x48\x8B\x05" bytes, optionally followed by a "xx?" mask.
+		///----------------------------------------------------------------------------------------------------
+		inline ParseResult ParseEscaped(std::string_view aText, std::vector<Byte>& aBytes)
+		{
+			uint64_t i = 0;
+
+			while (i < aText.size())
+			{
+				if (IsSeparator(aText[i]))
+				{
+					i++;
+					continue;
+				}
+
+				if (aText[i] != '\\')
+				{
+					/* The rest is the mask. */
+					break;
+				}
+
+				if (i + 3 >= aText.size() || (aText[i + 1] != 'x' && aText[i + 1] != 'X'))
+				{
+					return ParseResult{ EParseError::invalidCharacter, i };
+				}
+
+				int hi = HexValue(aText[i + 2]);
+				int lo = HexValue(aText[i + 3]);
+
+				if (hi < 0 || lo < 0)
+				{
+					return ParseResult{ EParseError::incompleteByte, i };
+				}
+
+				aBytes.push_back(Byte{ false, (uint8_t)(hi * HEXPOW_2 + lo) });
+
+				i += 4;
+			}
+
+			if (i < aText.size())
+			{
+				return ApplyMask(aText.substr(i), i, aBytes);
+			}
+
+			return ParseResult{};
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ParseHex:
+		/// 	Parses IDA "48 8B ? ? 05" and x64dbg "48 8B ?? ?? 05" / "488B????05" style bytes, with
+		/// 	nibble wildcards "4?" / "?8" and bitmasks "B8&F8".
+		///----------------------------------------------------------------------------------------------------
+		inline ParseResult ParseHex(std::string_view aText, std::vector<Byte>& aBytes)
+		{
+			uint64_t i = 0;
+
+			while (i < aText.size())
+			{
+				if (IsSeparator(aText[i]))
+				{
+					i++;
+					continue;
+				}
+
+				uint64_t start = i;
+
+				while (i < aText.size() && !IsSeparator(aText[i]))
+				{
+					i++;
+				}
+
+				std::string_view token = aText.substr(start, i - start);
+
+				/* Single digit or IDA single wildcard. */
+				if (token.size() == 1)
+				{
+					int val = HexValue(token[0]);
+
+					if (token[0] != '?' && val < 0)
+					{
+						return ParseResult{ EParseError::invalidCharacter, start };
+					}
+
+					aBytes.push_back(token[0] == '?' ? Byte{ true } : Byte{ false, (uint8_t)val });
+
+					continue;
+				}
+
+				for (uint64_t k = 0; k < token.size(); k += 2)
+				{
+					if (k + 1 >= token.size())
+					{
+						return ParseResult{ EParseError::incompleteByte, start + k };
+					}
+
+					char a = token[k];
+					char b = token[k + 1];
+
+					int hi = HexValue(a);
+					int lo = HexValue(b);
+
+					Byte byte{};
+
+					if (a == '?' && b == '?')
+					{
+						byte = Byte{ true };
+					}
+					else if (hi >= 0 && lo >= 0)
+					{
+						byte = Byte{ false, (uint8_t)(hi * HEXPOW_2 + lo) };
+					}
+					else if (a == '?' && lo >= 0)
+					{
+						byte = Byte{ false, (uint8_t)lo, 0x0F };
+					}
+					else if (hi >= 0 && b == '?')
+					{
+						byte = Byte{ false, (uint8_t)(hi * HEXPOW_2), 0xF0 };
+					}
+					else
+					{
+						return ParseResult{ EParseError::invalidCharacter, start + k + (hi >= 0 || a == '?') };
+					}
+
+					/* Explicit bitmask, e.g. 'B8&F8'. */
+					if (k + 2 < token.size() && token[k + 2] == '&')
+					{
+						int maskHi = k + 3 < token.size() ? HexValue(token[k + 3]) : -1;
+						int maskLo = k + 4 < token.size() ? HexValue(token[k + 4]) : -1;
+
+						if (maskHi < 0 || maskLo < 0)
+						{
+							return ParseResult{ EParseError::incompleteByte, start + k + 2 };
+						}
+
+						byte = Byte{ byte.IsWildcard, byte.Value, (uint8_t)(byte.Mask & (maskHi * HEXPOW_2 + maskLo)) };
+						k += 3;
+					}
+
+					aBytes.push_back(byte);
+				}
+			}
+
+			return ParseResult{};
+		}
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// Strcmp:
-	/// 	Interprets the current address as a relative address to a string, follows and compares it.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction Strcmp(const char* aStr) { return Instruction(EOperation::strcmp, aStr); }
+	/// ParsePattern:
+	/// 	Parses a pattern at runtime without throwing. Accepts hex of either case in IDA and x64dbg
+	/// 	style, and code-style escaped bytes with an optional mask: "\x48\x8B\x05" "xx?".
+	/// 	On failure aPattern is left empty and the result holds the error and position.
+	///----------------------------------------------------------------------------------------------------
+	inline ParseResult ParsePattern(std::string_view aText, Pattern& aPattern)
+	{
+		aPattern = Pattern();
+
+		bool escaped = false;
+
+		for (char c : aText)
+		{
+			if (parser::IsSeparator(c)) { continue; }
+
+			escaped = c == '\\';
+			break;
+		}
+
+		std::vector<Byte> bytes;
+		bytes.reserve(aText.size() / 2);
+
+		ParseResult result = escaped ? parser::ParseEscaped(aText, bytes) : parser::ParseHex(aText, bytes);
+
+		if (!result) { return result; }
+
+		if (bytes.empty())
+		{
+			return ParseResult{ EParseError::empty, 0 };
+		}
+
+		aPattern = Pattern(bytes.data(), bytes.size());
+
+		return result;
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// Wcscmp:
-	/// 	Interprets the current address as a relative address to a wstring, follows and compares it.
+	/// ParsePattern:
+	/// 	Parses a code-style byte array and mask pair. aBytes holds as many bytes as the mask has
+	/// 	characters, so it may contain zeros.
 	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction Wcscmp(const wchar_t* aWStr) { return Instruction(EOperation::wcscmp, aWStr); }
+	inline ParseResult ParsePattern(const char* aBytes, std::string_view aMask, Pattern& aPattern)
+	{
+		aPattern = Pattern();
+
+		if (aMask.empty())
+		{
+			return ParseResult{ EParseError::empty, 0 };
+		}
+
+		std::vector<Byte> bytes(aMask.size());
+
+		for (uint64_t i = 0; i < aMask.size(); i++)
+		{
+			char c = aMask[i];
+
+			if (c != 'x' && c != 'X' && c != '?' && c != '.')
+			{
+				return ParseResult{ EParseError::invalidMask, i };
+			}
+
+			bytes[i] = c == '?' || c == '.' ? Byte{ true } : Byte{ false, (uint8_t)aBytes[i] };
+		}
+
+		aPattern = Pattern(bytes.data(), bytes.size());
+
+		return ParseResult{};
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// CmpI8:
-	/// 	Interprets the current address as an i8 compares it.
+	/// SupportsAVX512BW:
+	/// 	Returns true if the CPU reports AVX-512F/BW and the OS saves the ZMM and opmask state.
 	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction CmpI8(int64_t aValue) { return Instruction(EOperation::cmpi8, aValue); }
+	inline bool SupportsAVX512BW()
+	{
+#ifdef MEMTOOLS_HAS_AVX512
+		static const bool s_Supported = []()
+		{
+			uint32_t regs[4]{};
+
+#ifdef _MSC_VER
+			__cpuidex((int*)regs, 1, 0);
+#else
+			__cpuid_count(1, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			/* OSXSAVE must be set before xgetbv may be executed. */
+			if (!(regs[2] & (1u << 27))) { return false; }
+
+#ifdef _MSC_VER
+			uint64_t xcr0 = _xgetbv(0);
+#else
+			uint32_t xcr0lo = 0;
+			uint32_t xcr0hi = 0;
+			__asm__ volatile("xgetbv" : "=a"(xcr0lo), "=d"(xcr0hi) : "c"(0));
+			uint64_t xcr0 = ((uint64_t)xcr0hi << 32) | xcr0lo;
+#endif
+			/* SSE, AVX, opmask, ZMM_Hi256 and Hi16_ZMM state must be enabled. */
+			if ((xcr0 & 0xE6) != 0xE6) { return false; }
+
+#ifdef _MSC_VER
+			__cpuidex((int*)regs, 7, 0);
+#else
+			__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			/* AVX512F (bit 16), BMI1 (bit 3) and AVX512BW (bit 30). */
+			return (regs[1] & (1u << 16)) && (regs[1] & (1u << 3)) && (regs[1] & (1u << 30));
+		}();
+
+		return s_Supported;
+#else
+		return false;
+#endif
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// CmpI16:
-	/// 	Interprets the current address as an i16 compares it.
+	/// CountTrailingZeros:
+	/// 	Returns the index of the lowest set bit. aValue must not be 0.
 	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction CmpI16(int64_t aValue) { return Instruction(EOperation::cmpi16, aValue); }
+	inline uint64_t CountTrailingZeros(uint64_t aValue)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, aValue);
+		return index;
+#else
+		return (uint64_t)__builtin_ctzll(aValue);
+#endif
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// CmpI32:
-	/// 	Interprets the current address as an i32 compares it.
+	/// CountLeadingZeros:
+	/// 	Returns 63 minus the index of the highest set bit. aValue must not be 0.
 	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction CmpI32(int64_t aValue) { return Instruction(EOperation::cmpi32, aValue); }
+	inline uint64_t CountLeadingZeros(uint64_t aValue)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, aValue);
+		return 63 - index;
+#else
+		return (uint64_t)__builtin_clzll(aValue);
+#endif
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// CmpI64:
-	/// 	Interprets the current address as an i64 compares it.
+	/// FindPatternScalar:
+	/// 	Returns the first address at or after aBase + aStart where the pattern matches, or nullptr.
+	/// 	The pattern is never compared past aBase + aSize.
 	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction CmpI64(int64_t aValue) { return Instruction(EOperation::cmpi64, aValue); }
+	inline PBYTE FindPatternScalar(const Pattern& aPattern, PBYTE aBase, uint64_t aSize, uint64_t aStart = 0)
+	{
+		if (aPattern.Size == 0 || aPattern.Size > aSize) { return nullptr; }
+
+		uint64_t last = aSize - aPattern.Size;
+
+		for (uint64_t i = aStart; i <= last; i++)
+		{
+			if (aPattern == &aBase[i])
+			{
+				return &aBase[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+#ifdef MEMTOOLS_HAS_AVX512
+	///----------------------------------------------------------------------------------------------------
+	/// FindPatternAVX512:
+	/// 	Tests 64 offsets per iteration. Every concrete pattern byte is compared against 64 consecutive
+	/// 	offsets using masked loads, where the mask only contains offsets that are still candidates.
+	/// 	Lanes past the last valid offset are masked off, so region tails never touch unmapped memory.
+	/// 	Bytes with a partial mask are masked before the comparison.
+	/// 	Long patterns filter with their first FILTER_BYTES concrete bytes and verify the rest.
+	///----------------------------------------------------------------------------------------------------
+	MEMTOOLS_TARGET_AVX512BW inline PBYTE FindPatternAVX512(const Pattern& aPattern, PBYTE aBase, uint64_t aSize, uint64_t aStart = 0)
+	{
+		static constexpr uint64_t FILTER_BYTES = 32;
+
+		if (aPattern.Size == 0 || aPattern.Size > aSize) { return nullptr; }
+
+		/* Collect the concrete bytes once, wildcards need no comparison. */
+		const Byte* pattern = aPattern.Data();
+		uint32_t    concreteOffsets[FILTER_BYTES];
+		__m512i     concreteValues[FILTER_BYTES];
+		__m512i     concreteMasks[FILTER_BYTES];
+		uint32_t    partial       = 0; /* bit k set if concrete byte k has a partial mask */
+		uint64_t    concreteCount = 0;
+		bool        verify        = false;
+
+		for (uint64_t j = 0; j < aPattern.Size; j++)
+		{
+			if (pattern[j].IsWildcard) { continue; }
+
+			if (concreteCount == FILTER_BYTES)
+			{
+				verify = true;
+				break;
+			}
+
+			if (!pattern[j].IsExact())
+			{
+				partial |= 1u << concreteCount;
+			}
+
+			concreteOffsets[concreteCount] = (uint32_t)j;
+			concreteValues[concreteCount] = _mm512_set1_epi8((char)pattern[j].Value);
+			concreteMasks[concreteCount] = _mm512_set1_epi8((char)pattern[j].Mask);
+			concreteCount++;
+		}
+
+		uint64_t count = aSize - aPattern.Size + 1; /* number of offsets the pattern fits at */
+
+		for (uint64_t i = aStart; i < count; i += 64)
+		{
+			uint64_t  lanes      = count - i;
+			__mmask64 candidates = lanes >= 64 ? ~0ULL : (1ULL << lanes) - 1;
+
+			for (uint64_t k = 0; k < concreteCount && candidates; k++)
+			{
+				__m512i block = _mm512_maskz_loadu_epi8(candidates, &aBase[i + concreteOffsets[k]]);
+
+				if (partial & (1u << k))
+				{
+					block = _mm512_and_si512(block, concreteMasks[k]);
+				}
+
+				candidates = _mm512_mask_cmpeq_epi8_mask(candidates, block, concreteValues[k]);
+			}
+
+			while (candidates)
+			{
+				PBYTE match = &aBase[i + _tzcnt_u64(candidates)];
+
+				if (!verify || aPattern == match)
+				{
+					return match;
+				}
+
+				candidates &= candidates - 1;
+			}
+		}
+
+		return nullptr;
+	}
+#endif
+
+	///----------------------------------------------------------------------------------------------------
+	/// FindPattern:
+	/// 	Returns the first address at or after aBase + aStart where the pattern matches, or nullptr.
+	/// 	Uses the AVX-512BW matcher if available.
+	///----------------------------------------------------------------------------------------------------
+	inline PBYTE FindPattern(const Pattern& aPattern, PBYTE aBase, uint64_t aSize, uint64_t aStart = 0)
+	{
+#ifdef MEMTOOLS_HAS_AVX512
+		if (SupportsAVX512BW())
+		{
+			return FindPatternAVX512(aPattern, aBase, aSize, aStart);
+		}
+#endif
+
+		return FindPatternScalar(aPattern, aBase, aSize, aStart);
+	}
+
+#ifndef _WIN32
+	///----------------------------------------------------------------------------------------------------
+	/// ProcmapQuery Struct
+	/// 	struct procmap_query of <linux/fs.h> (Linux 6.11), declared here for older headers.
+	///----------------------------------------------------------------------------------------------------
+	struct ProcmapQuery
+	{
+		uint64_t Size;
+		uint64_t QueryFlags;
+		uint64_t QueryAddr;
+		uint64_t VmaStart;
+		uint64_t VmaEnd;
+		uint64_t VmaFlags;
+		uint64_t VmaPageSize;
+		uint64_t VmaOffset;
+		uint64_t Inode;
+		uint32_t DevMajor;
+		uint32_t DevMinor;
+		uint32_t VmaNameSize;
+		uint32_t BuildIdSize;
+		uint64_t VmaNameAddr;
+		uint64_t BuildIdAddr;
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// ForEachRegionProcmapQuery:
+	/// 	Enumerates the readable and executable VMAs with the PROCMAP_QUERY ioctl, which filters in
+	/// 	the kernel and returns binary records. Returns false if the kernel doesn't support it.
+	///----------------------------------------------------------------------------------------------------
+	template <typename Fn>
+	inline bool ForEachRegionProcmapQuery(PBYTE aStart, Fn& aCallback, PBYTE aEnd)
+	{
+#ifdef MEMTOOLS_DISABLE_PROCMAP_QUERY
+		return false;
+#else
+		/* _IOWR('f', 17, struct procmap_query) */
+		constexpr unsigned long PROCMAP_QUERY = (3UL << 30) | ((unsigned long)sizeof(ProcmapQuery) << 16) | ('f' << 8) | 17;
+
+		constexpr uint64_t VMA_READABLE          = 0x01;
+		constexpr uint64_t VMA_EXECUTABLE        = 0x04;
+		constexpr uint64_t COVERING_OR_NEXT_VMA  = 0x10;
+
+		static std::atomic<bool> s_Unsupported{ false };
+
+		if (s_Unsupported.load(std::memory_order_relaxed)) { return false; }
+
+		int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+
+		if (maps < 0) { return false; }
+
+		uint64_t addr  = (uintptr_t)aStart;
+		bool     first = true;
+
+		while (!aEnd || addr < (uintptr_t)aEnd)
+		{
+			ProcmapQuery query{};
+			query.Size       = sizeof(query);
+			query.QueryFlags = COVERING_OR_NEXT_VMA | VMA_READABLE | VMA_EXECUTABLE;
+			query.QueryAddr  = addr;
+
+			if (ioctl(maps, PROCMAP_QUERY, &query) != 0)
+			{
+				/* ENOENT: no more VMAs. Anything else on the first query: not supported. */
+				if (first && errno != ENOENT)
+				{
+					s_Unsupported.store(true, std::memory_order_relaxed);
+					close(maps);
+					return false;
+				}
+
+				break;
+			}
+
+			first = false;
+			addr  = query.VmaEnd;
+
+			if (aEnd && query.VmaStart >= (uintptr_t)aEnd) { break; }
+
+			if (!aCallback((PBYTE)(uintptr_t)query.VmaStart, query.VmaEnd - query.VmaStart))
+			{
+				break;
+			}
+		}
+
+		close(maps);
+
+		return true;
+#endif
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// ForEachRegionProcMaps:
+	/// 	Enumerates the readable and executable regions by parsing /proc/self/maps.
+	///----------------------------------------------------------------------------------------------------
+	template <typename Fn>
+	inline void ForEachRegionProcMaps(PBYTE aStart, Fn& aCallback, PBYTE aEnd)
+	{
+		FILE* maps = fopen("/proc/self/maps", "r");
+
+		if (!maps) { return; }
+
+		char*  line    = nullptr;
+		size_t lineCap = 0;
+
+		while (getline(&line, &lineCap, maps) != -1)
+		{
+			unsigned long long start = 0;
+			unsigned long long end   = 0;
+			char               perms[5]{};
+
+			if (sscanf(line, "%llx-%llx %4s", &start, &end, perms) != 3)
+			{
+				continue;
+			}
+
+			/* Skip regions before the start address. */
+			if (end <= (uintptr_t)aStart)
+			{
+				continue;
+			}
+
+			/* Regions are sorted, stop at the end address. */
+			if (aEnd && start >= (uintptr_t)aEnd)
+			{
+				break;
+			}
+
+			/* Skip pages without read and execute permission. */
+			if (perms[0] != 'r' || perms[2] != 'x')
+			{
+				continue;
+			}
+
+			if (!aCallback((PBYTE)(uintptr_t)start, (uint64_t)(end - start)))
+			{
+				break;
+			}
+		}
+
+		free(line);
+		fclose(maps);
+	}
+#endif
+
+	///----------------------------------------------------------------------------------------------------
+	/// ForEachRegion:
+	/// 	Invokes aCallback(PBYTE aBase, uint64_t aSize) for every committed executable and readable
+	/// 	region, starting with the region containing aStart and ending before aEnd, if given.
+	/// 	Stops once the callback returns false.
+	/// 	On Linux the PROCMAP_QUERY ioctl is used if available, /proc/self/maps is parsed otherwise.
+	///----------------------------------------------------------------------------------------------------
+	template <typename Fn>
+	inline void ForEachRegion(PBYTE aStart, Fn aCallback, PBYTE aEnd = nullptr)
+	{
+#ifdef _WIN32
+		PBYTE addr = aStart;
+
+		MEMORY_BASIC_INFORMATION mbi{};
+
+		/* If virtual query fails, stop scanning. */
+		while ((!aEnd || addr < aEnd) && VirtualQuery(addr, &mbi, sizeof(mbi)))
+		{
+			/* Advance query address into the next page. */
+			addr = (PBYTE)mbi.BaseAddress + mbi.RegionSize;
+
+			/* Skip uncommitted pages. */
+			if (mbi.State != MEM_COMMIT)
+			{
+				continue;
+			}
+
+			/* Skip pages without read permission. */
+			if (!(mbi.Protect == PAGE_EXECUTE_READ || mbi.Protect == PAGE_EXECUTE_READWRITE))
+			{
+				continue;
+			}
+
+			if (!aCallback((PBYTE)mbi.BaseAddress, (uint64_t)mbi.RegionSize))
+			{
+				break;
+			}
+		}
+#else
+		if (ForEachRegionProcmapQuery(aStart, aCallback, aEnd)) { return; }
+
+		/* Older kernels, parse the text. */
+		ForEachRegionProcMaps(aStart, aCallback, aEnd);
+#endif
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// Range Struct
+	/// 	A range of memory, relative to a module base if used in an index.
+	///----------------------------------------------------------------------------------------------------
+	struct Range
+	{
+		uint64_t Offset = 0;
+		uint64_t Size   = 0;
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// GetModuleBase:
+	/// 	Returns the base address of a loaded module containing aName, or the main module for nullptr.
+	///----------------------------------------------------------------------------------------------------
+	inline PBYTE GetModuleBase(const char* aName = nullptr)
+	{
+#ifdef _WIN32
+		return (PBYTE)GetModuleHandleA(aName);
+#else
+		struct Query
+		{
+			const char* Name;
+			PBYTE       Base;
+		} query{ aName, nullptr };
+
+		dl_iterate_phdr([](dl_phdr_info* aInfo, size_t, void* aData) -> int
+		{
+			Query* query = (Query*)aData;
+
+			/* The first entry is the main module. */
+			if (query->Name && (!aInfo->dlpi_name || !strstr(aInfo->dlpi_name, query->Name)))
+			{
+				return 0;
+			}
+
+			for (ElfW(Half) i = 0; i < aInfo->dlpi_phnum; i++)
+			{
+				/* The segment mapping the file start also maps the ELF header. */
+				if (aInfo->dlpi_phdr[i].p_type == PT_LOAD && aInfo->dlpi_phdr[i].p_offset == 0)
+				{
+					query->Base = (PBYTE)(aInfo->dlpi_addr + aInfo->dlpi_phdr[i].p_vaddr);
+					return 1;
+				}
+			}
+
+			return 0;
+		}, &query);
+
+		return query.Base;
+#endif
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// GetModuleBaseFromAddress:
+	/// 	Returns the base address of the loaded module containing aAddress, or nullptr.
+	///----------------------------------------------------------------------------------------------------
+	inline PBYTE GetModuleBaseFromAddress(const void* aAddress)
+	{
+#ifdef _WIN32
+		HMODULE module = nullptr;
+
+		if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)aAddress, &module))
+		{
+			return nullptr;
+		}
+
+		return (PBYTE)module;
+#else
+		struct Query
+		{
+			uintptr_t Address;
+			PBYTE     Base;
+		} query{ (uintptr_t)aAddress, nullptr };
+
+		dl_iterate_phdr([](dl_phdr_info* aInfo, size_t, void* aData) -> int
+		{
+			Query* query = (Query*)aData;
+
+			PBYTE base     = nullptr;
+			bool  contains = false;
+
+			for (ElfW(Half) i = 0; i < aInfo->dlpi_phnum; i++)
+			{
+				const ElfW(Phdr)& phdr = aInfo->dlpi_phdr[i];
+
+				if (phdr.p_type != PT_LOAD) { continue; }
+
+				uintptr_t start = aInfo->dlpi_addr + phdr.p_vaddr;
+
+				if (phdr.p_offset == 0) { base = (PBYTE)start; }
+				if (query->Address >= start && query->Address < start + phdr.p_memsz) { contains = true; }
+			}
+
+			if (!contains) { return 0; }
+
+			query->Base = base;
+			return 1;
+		}, &query);
+
+		return query.Base;
+#endif
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// ESectionType Enumeration
+	///----------------------------------------------------------------------------------------------------
+	enum class ESectionType
+	{
+		executable, /* code */
+		readonly    /* readable, neither writable nor executable, e.g. .rdata / .rodata */
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// GetSections:
+	/// 	Parses a PE or ELF64 image and returns its sections of a type relative to aImage.
+	/// 	Set aIsMapped to false if the image is a file read from disk instead of a loaded module, and
+	/// 	pass the file size as aSize. Headers outside of it yield no sections, and file sections are
+	/// 	clipped to it.
+	/// 	ELF images are described by their loadable segments.
+	///----------------------------------------------------------------------------------------------------
+	inline std::vector<Range> GetSections(const void* aImage, ESectionType aType, bool aIsMapped = true, uint64_t aSize = UINT64_MAX)
+	{
+		std::vector<Range> sections;
+
+		const uint8_t* image = (const uint8_t*)aImage;
+
+		auto fits = [aSize](uint64_t aOffset, uint64_t aLength) { return aOffset <= aSize && aLength <= aSize - aOffset; };
+
+		if (!image || !fits(0, 0x40)) { return sections; }
+
+		auto read16 = [image](uint64_t aOffset) { uint16_t v; memcpy(&v, image + aOffset, sizeof(v)); return v; };
+		auto read32 = [image](uint64_t aOffset) { uint32_t v; memcpy(&v, image + aOffset, sizeof(v)); return v; };
+		auto read64 = [image](uint64_t aOffset) { uint64_t v; memcpy(&v, image + aOffset, sizeof(v)); return v; };
+
+		/* File sections past the end of the data are clipped. */
+		auto addFileRange = [&](uint64_t aOffset, uint64_t aLength)
+		{
+			if (aOffset < aSize) { sections.push_back(Range{ aOffset, std::min(aLength, aSize - aOffset) }); }
+		};
+
+		if (image[0] == 'M' && image[1] == 'Z')
+		{
+			uint32_t nt = read32(0x3C); /* e_lfanew */
+
+			if (!fits(nt, 24) || read32(nt) != 0x00004550) { return sections; } /* "PE\0\0" */
+
+			uint16_t sectionCount  = read16(nt + 6);
+			uint16_t optHeaderSize = read16(nt + 20);
+			uint64_t sectionTable  = (uint64_t)nt + 24 + optHeaderSize;
+
+			if (!fits(sectionTable, (uint64_t)sectionCount * 40)) { return sections; }
+
+			for (uint16_t i = 0; i < sectionCount; i++)
+			{
+				uint64_t header = sectionTable + i * 40;
+
+				/* IMAGE_SCN_MEM_EXECUTE, IMAGE_SCN_MEM_READ, IMAGE_SCN_MEM_WRITE */
+				uint32_t characteristics = read32(header + 36);
+				bool     isExecutable    = characteristics & 0x20000000;
+				bool     isReadOnly      = (characteristics & 0xE0000000) == 0x40000000;
+
+				if (aType == ESectionType::executable ? !isExecutable : !isReadOnly) { continue; }
+
+				uint32_t virtualSize = read32(header + 8);
+				uint32_t rawSize     = read32(header + 16);
+
+				if (aIsMapped)
+				{
+					sections.push_back(Range{ read32(header + 12), virtualSize ? virtualSize : rawSize });
+				}
+				else
+				{
+					addFileRange(read32(header + 20), virtualSize ? std::min(virtualSize, rawSize) : rawSize);
+				}
+			}
+		}
+		else if (image[0] == 0x7F && image[1] == 'E' && image[2] == 'L' && image[3] == 'F' && image[4] == 2 /* ELFCLASS64 */)
+		{
+			uint64_t phoff     = read64(0x20);
+			uint16_t phentsize = read16(0x36);
+			uint16_t phnum     = read16(0x38);
+
+			if (phentsize < 0x38 || !fits(phoff, (uint64_t)phnum * phentsize)) { return sections; }
+
+			/* Segment addresses are relative to the first loaded segment. */
+			uint64_t firstVaddr = UINT64_MAX;
+
+			for (uint16_t i = 0; i < phnum; i++)
+			{
+				uint64_t header = phoff + (uint64_t)i * phentsize;
+
+				if (read32(header) == 1 /* PT_LOAD */)
+				{
+					firstVaddr = std::min<uint64_t>(firstVaddr, read64(header + 0x10) & ~0xFFFULL);
+				}
+			}
+
+			for (uint16_t i = 0; i < phnum; i++)
+			{
+				uint64_t header = phoff + (uint64_t)i * phentsize;
+
+				/* PT_LOAD with PF_X, or with only PF_R */
+				uint32_t flags        = read32(header + 4);
+				bool     isExecutable = flags & 1;
+				bool     isReadOnly   = (flags & 7) == 4;
+
+				if (read32(header) != 1 || (aType == ESectionType::executable ? !isExecutable : !isReadOnly)) { continue; }
+
+				if (aIsMapped)
+				{
+					sections.push_back(Range{ read64(header + 0x10) - firstVaddr, read64(header + 0x28) });
+				}
+				else
+				{
+					addFileRange(read64(header + 0x08), read64(header + 0x20));
+				}
+			}
+		}
+
+		return sections;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// GetExecutableSections:
+	/// 	Returns the executable sections of a PE or ELF64 image relative to aImage, see GetSections.
+	///----------------------------------------------------------------------------------------------------
+	inline std::vector<Range> GetExecutableSections(const void* aImage, bool aIsMapped = true, uint64_t aSize = UINT64_MAX)
+	{
+		return GetSections(aImage, ESectionType::executable, aIsMapped, aSize);
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// SameSections:
+	/// 	Returns true if two section tables are equal, e.g. one read from a file and the image's own.
+	///----------------------------------------------------------------------------------------------------
+	inline bool SameSections(const std::vector<Range>& aLhs, const std::vector<Range>& aRhs)
+	{
+		return std::equal(aLhs.begin(), aLhs.end(), aRhs.begin(), aRhs.end(), [](const Range& aL, const Range& aR)
+		{
+			return aL.Offset == aR.Offset && aL.Size == aR.Size;
+		});
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// HashBytes:
+	/// 	FNV-1a hash, used to fingerprint images and serialized data.
+	///----------------------------------------------------------------------------------------------------
+	inline uint64_t HashBytes(const void* aData, uint64_t aSize, uint64_t aSeed = 0xCBF29CE484222325ULL)
+	{
+		const uint8_t* data = (const uint8_t*)aData;
+
+		for (uint64_t i = 0; i < aSize; i++)
+		{
+			aSeed = (aSeed ^ data[i]) * 0x100000001B3ULL;
+		}
+
+		return aSeed;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// FingerprintModule:
+	/// 	Hashes the headers and the start of every executable section, to detect a changed module.
+	///----------------------------------------------------------------------------------------------------
+	inline uint64_t FingerprintModule(const void* aModuleBase, const std::vector<Range>& aSections)
+	{
+		const uint8_t* base = (const uint8_t*)aModuleBase;
+
+		uint64_t hash = HashBytes(base, 0x400);
+
+		for (const Range& section : aSections)
+		{
+			hash = HashBytes(&section, sizeof(section), hash);
+			hash = HashBytes(base + section.Offset, std::min<uint64_t>(section.Size, 0x1000), hash);
+		}
+
+		return hash;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// MappedFile Struct
+	/// 	Read-only memory mapping of a file.
+	///----------------------------------------------------------------------------------------------------
+	struct MappedFile
+	{
+		const uint8_t* Data = nullptr;
+		uint64_t       Size = 0;
+
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		inline MappedFile(MappedFile&& aOther) noexcept
+			: Data(aOther.Data)
+			, Size(aOther.Size)
+		{
+			aOther.Data = nullptr;
+			aOther.Size = 0;
+		}
+
+		inline MappedFile& operator=(MappedFile&& aOther) noexcept
+		{
+			if (this == &aOther) { return *this; }
+
+			this->Close();
+			this->Data = aOther.Data;
+			this->Size = aOther.Size;
+			aOther.Data = nullptr;
+			aOther.Size = 0;
+
+			return *this;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// dtor
+		///----------------------------------------------------------------------------------------------------
+		inline ~MappedFile()
+		{
+			this->Close();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Open:
+		/// 	Maps the whole file. Returns false if the file could not be mapped.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Open(const char* aPath)
+		{
+			this->Close();
+
+#ifdef _WIN32
+			HANDLE file = CreateFileA(aPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+			if (file == INVALID_HANDLE_VALUE) { return false; }
+
+			LARGE_INTEGER size{};
+
+			if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			{
+				CloseHandle(file);
+				return false;
+			}
+
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+
+			if (!mapping) { return false; }
+
+			void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+
+			if (!view) { return false; }
+
+			this->Data = (const uint8_t*)view;
+			this->Size = (uint64_t)size.QuadPart;
+#else
+			int file = open(aPath, O_RDONLY);
+
+			if (file < 0) { return false; }
+
+			struct stat info{};
+
+			if (fstat(file, &info) != 0 || info.st_size == 0)
+			{
+				close(file);
+				return false;
+			}
+
+			void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			close(file);
+
+			if (view == MAP_FAILED) { return false; }
+
+			this->Data = (const uint8_t*)view;
+			this->Size = (uint64_t)info.st_size;
+#endif
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Close:
+		/// 	Unmaps the file.
+		///----------------------------------------------------------------------------------------------------
+		inline void Close()
+		{
+			if (!this->Data) { return; }
+
+#ifdef _WIN32
+			UnmapViewOfFile(this->Data);
+#else
+			munmap((void*)this->Data, (size_t)this->Size);
+#endif
+
+			this->Data = nullptr;
+			this->Size = 0;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// NgramIndex Struct
+	/// 	Inverted index of every 4-byte n-gram in the executable sections of a module.
+	/// 	Positions are bucketed by the first two bytes of the n-gram and sorted by the last two bytes,
+	/// 	then by position. A lookup is a bucket access plus a binary search.
+	///
+	/// 	On-disk layout (little endian, all arrays directly follow each other):
+	/// 		NgramIndex::Header
+	/// 		Range    Sections[SectionCount]
+	/// 		uint32_t Buckets[BUCKET_COUNT + 1]
+	/// 		uint32_t Positions[PositionCount]   module relative offsets
+	/// 		uint16_t HighKeys[PositionCount]    last two bytes of the n-gram at each position
+	///----------------------------------------------------------------------------------------------------
+	struct NgramIndex
+	{
+		static constexpr uint32_t BUCKET_COUNT = 0x10000;
+		static constexpr uint32_t MAGIC        = 0x474E544D; /* "MTNG" */
+		static constexpr uint32_t VERSION      = 1;
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t Fingerprint;
+			uint64_t SectionCount;
+			uint64_t PositionCount;
+		};
+
+		PBYTE              ModuleBase    = nullptr;
+		uint64_t           Fingerprint   = 0;
+		std::vector<Range> Sections;
+		const uint32_t*    Buckets       = nullptr;
+		const uint32_t*    Positions     = nullptr;
+		const uint16_t*    HighKeys      = nullptr;
+		uint64_t           PositionCount = 0;
+
+		NgramIndex() = default;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Builds the index over the executable sections of a loaded module.
+		///----------------------------------------------------------------------------------------------------
+		inline explicit NgramIndex(const void* aModuleBase)
+		{
+			if (!aModuleBase) { throw "Module base is nullptr."; }
+
+			this->ModuleBase  = (PBYTE)aModuleBase;
+			this->Sections    = GetExecutableSections(aModuleBase);
+			this->Fingerprint = FingerprintModule(aModuleBase, this->Sections);
+
+			/* Count positions per bucket. */
+			this->OwnedBuckets.assign(BUCKET_COUNT + 1, 0);
+
+			for (const Range& section : this->Sections)
+			{
+				if (section.Size < 4) { continue; }
+
+				PBYTE base = this->ModuleBase + section.Offset;
+
+				for (uint64_t i = 0; i + 4 <= section.Size; i++)
+				{
+					this->OwnedBuckets[(uint32_t)base[i] | ((uint32_t)base[i + 1] << 8)]++;
+				}
+			}
+
+			uint32_t total = 0;
+
+			for (uint32_t b = 0; b <= BUCKET_COUNT; b++)
+			{
+				uint32_t count = this->OwnedBuckets[b];
+				this->OwnedBuckets[b] = total;
+				total += count;
+			}
+
+			/* Scatter positions into their buckets, in ascending order. */
+			this->OwnedPositions.resize(total);
+			std::vector<uint32_t> cursor(this->OwnedBuckets.begin(), this->OwnedBuckets.end() - 1);
+
+			for (const Range& section : this->Sections)
+			{
+				if (section.Size < 4) { continue; }
+
+				PBYTE base = this->ModuleBase + section.Offset;
+
+				for (uint64_t i = 0; i + 4 <= section.Size; i++)
+				{
+					this->OwnedPositions[cursor[(uint32_t)base[i] | ((uint32_t)base[i + 1] << 8)]++] = (uint32_t)(section.Offset + i);
+				}
+			}
+
+			/* Sort every bucket by the last two bytes, keeping position order (stable). */
+			this->OwnedHighKeys.resize(total);
+			PBYTE module = this->ModuleBase;
+
+			for (uint32_t b = 0; b < BUCKET_COUNT; b++)
+			{
+				uint32_t* first = this->OwnedPositions.data() + this->OwnedBuckets[b];
+				uint32_t* last  = this->OwnedPositions.data() + this->OwnedBuckets[b + 1];
+
+				std::stable_sort(first, last, [module](uint32_t aLhs, uint32_t aRhs)
+				{
+					return ReadHighKey(module, aLhs) < ReadHighKey(module, aRhs);
+				});
+
+				for (uint32_t* it = first; it != last; it++)
+				{
+					this->OwnedHighKeys[it - this->OwnedPositions.data()] = ReadHighKey(module, *it);
+				}
+			}
+
+			this->Buckets       = this->OwnedBuckets.data();
+			this->Positions     = this->OwnedPositions.data();
+			this->HighKeys      = this->OwnedHighKeys.data();
+			this->PositionCount = total;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsValid:
+		/// 	Returns true if the index was built or loaded.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsValid() const
+		{
+			return this->Buckets != nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Find:
+		/// 	Returns the sorted module relative positions of a 4-byte n-gram.
+		/// 	The n-gram is read little endian, i.e. the first byte is the lowest.
+		///----------------------------------------------------------------------------------------------------
+		inline std::pair<const uint32_t*, const uint32_t*> Find(uint32_t aNgram) const
+		{
+			if (!this->IsValid()) { return { nullptr, nullptr }; }
+
+			uint32_t bucket = aNgram & 0xFFFF;
+			uint16_t high   = (uint16_t)(aNgram >> 16);
+
+			const uint16_t* first = this->HighKeys + this->Buckets[bucket];
+			const uint16_t* last  = this->HighKeys + this->Buckets[bucket + 1];
+
+			auto range = std::equal_range(first, last, high);
+
+			return { this->Positions + (range.first - this->HighKeys), this->Positions + (range.second - this->HighKeys) };
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Save:
+		/// 	Writes the index to disk, so it can be mapped with Load instead of being rebuilt.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Save(const char* aPath) const
+		{
+			if (!this->IsValid()) { return false; }
+
+			FILE* file = fopen(aPath, "wb");
+
+			if (!file) { return false; }
+
+			Header header{ MAGIC, VERSION, this->Fingerprint, this->Sections.size(), this->PositionCount };
+
+			bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+			success = success && fwrite(this->Sections.data(), sizeof(Range), this->Sections.size(), file) == this->Sections.size();
+			success = success && fwrite(this->Buckets, sizeof(uint32_t), BUCKET_COUNT + 1, file) == BUCKET_COUNT + 1;
+			success = success && fwrite(this->Positions, sizeof(uint32_t), this->PositionCount, file) == this->PositionCount;
+			success = success && fwrite(this->HighKeys, sizeof(uint16_t), this->PositionCount, file) == this->PositionCount;
+
+			return fclose(file) == 0 && success;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Load:
+		/// 	Maps an index saved with Save. Nothing is copied except the section table, which has to match
+		/// 	the module's, the buckets and positions are only bounds checked.
+		/// 	Returns false if the file is invalid or was built from a different module.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Load(const char* aPath, const void* aModuleBase)
+		{
+			*this = NgramIndex();
+
+			if (!aModuleBase || !this->File.Open(aPath)) { return false; }
+
+			const uint8_t* data = this->File.Data;
+
+			Header header;
+			if (this->File.Size < sizeof(header)) { return false; }
+			memcpy(&header, data, sizeof(header));
+
+			if (header.Magic != MAGIC || header.Version != VERSION) { return false; }
+
+			uint64_t sectionsOffset  = sizeof(Header);
+			uint64_t bucketsOffset   = sectionsOffset + header.SectionCount * sizeof(Range);
+			uint64_t positionsOffset = bucketsOffset + (BUCKET_COUNT + 1) * sizeof(uint32_t);
+			uint64_t highKeysOffset  = positionsOffset + header.PositionCount * sizeof(uint32_t);
+			uint64_t end             = highKeysOffset + header.PositionCount * sizeof(uint16_t);
+
+			if (header.SectionCount > this->File.Size || header.PositionCount > this->File.Size || end != this->File.Size) { return false; }
+
+			std::vector<Range> sections(header.SectionCount);
+			memcpy(sections.data(), data + sectionsOffset, sections.size() * sizeof(Range));
+
+			/* The section table is only hashed once it is known to be the module's own. Reject indices
+			   of a different module or build. */
+			if (!SameSections(sections, GetExecutableSections(aModuleBase))) { return false; }
+			if (FingerprintModule(aModuleBase, sections) != header.Fingerprint) { return false; }
+
+			const uint32_t* buckets   = (const uint32_t*)(data + bucketsOffset);
+			const uint32_t* positions = (const uint32_t*)(data + positionsOffset);
+
+			/* Buckets must partition the positions, and every n-gram lie inside a section. */
+			if (buckets[0] != 0 || buckets[BUCKET_COUNT] != header.PositionCount) { return false; }
+
+			for (uint32_t b = 0; b < BUCKET_COUNT; b++)
+			{
+				if (buckets[b] > buckets[b + 1]) { return false; }
+			}
+
+			for (uint64_t i = 0; i < header.PositionCount; i++)
+			{
+				bool isInside = false;
+
+				for (const Range& section : sections)
+				{
+					if (positions[i] >= section.Offset && section.Size >= 4 && positions[i] - section.Offset <= section.Size - 4)
+					{
+						isInside = true;
+						break;
+					}
+				}
+
+				if (!isInside) { return false; }
+			}
+
+			this->ModuleBase    = (PBYTE)aModuleBase;
+			this->Fingerprint   = header.Fingerprint;
+			this->Sections      = std::move(sections);
+			this->Buckets       = buckets;
+			this->Positions     = positions;
+			this->HighKeys      = (const uint16_t*)(data + highKeysOffset);
+			this->PositionCount = header.PositionCount;
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// SectionOf:
+		/// 	Returns the section containing the module relative offset, or nullptr.
+		///----------------------------------------------------------------------------------------------------
+		inline const Range* SectionOf(uint64_t aOffset) const
+		{
+			for (const Range& section : this->Sections)
+			{
+				if (aOffset >= section.Offset && aOffset < section.Offset + section.Size)
+				{
+					return &section;
+				}
+			}
+
+			return nullptr;
+		}
+
+	private:
+		std::vector<uint32_t> OwnedBuckets;
+		std::vector<uint32_t> OwnedPositions;
+		std::vector<uint16_t> OwnedHighKeys;
+		MappedFile            File;
+
+		static inline uint16_t ReadHighKey(PBYTE aModule, uint32_t aOffset)
+		{
+			return (uint16_t)(aModule[aOffset + 2] | (aModule[aOffset + 3] << 8));
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// SuffixIndex Struct
+	/// 	Suffix array over the executable sections of an image, for repeated ad-hoc pattern queries.
+	/// 	Every section is sorted separately, so no match crosses a section boundary.
+	/// 	Concrete bytes narrow the suffix interval by binary search, wildcards split it into one
+	/// 	sub-interval per distinct byte. Query time depends on the pattern, not on the image size.
+	///
+	/// 	On-disk layout (little endian, all arrays directly follow each other):
+	/// 		SuffixIndex::Header
+	/// 		Range    Sections[SectionCount]
+	/// 		uint8_t  Text[TextSize]             section bytes, concatenated
+	/// 		uint8_t  Padding[]                  up to a multiple of 4
+	/// 		uint32_t Suffixes[TextSize]         text positions, sorted per section
+	///----------------------------------------------------------------------------------------------------
+	struct SuffixIndex
+	{
+		static constexpr uint32_t MAGIC   = 0x4153544D; /* "MTSA" */
+		static constexpr uint32_t VERSION = 1;
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t Fingerprint;
+			uint64_t SectionCount;
+			uint64_t TextSize;
+		};
+
+		PBYTE              ImageBase   = nullptr;
+		uint64_t           Fingerprint = 0;
+		std::vector<Range> Sections;
+		const uint8_t*     Text        = nullptr;
+		const uint32_t*    Suffixes    = nullptr;
+		uint64_t           TextSize    = 0;
+
+		SuffixIndex() = default;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Builds the suffix array over the executable sections of an image.
+		/// 	Set aIsMapped to false if the image is a file read from disk instead of a loaded module, and
+		/// 	pass the file size as aSize.
+		///----------------------------------------------------------------------------------------------------
+		inline explicit SuffixIndex(const void* aImage, bool aIsMapped = true, uint64_t aSize = UINT64_MAX)
+		{
+			if (!aImage)       { throw "Image is nullptr."; }
+			if (aSize < 0x400) { throw "Image is too small."; } /* the headers are fingerprinted */
+
+			this->ImageBase   = (PBYTE)aImage;
+			this->Sections    = GetExecutableSections(aImage, aIsMapped, aSize);
+			this->Fingerprint = FingerprintModule(aImage, this->Sections);
+
+			for (const Range& section : this->Sections)
+			{
+				this->OwnedText.insert(this->OwnedText.end(), this->ImageBase + section.Offset, this->ImageBase + section.Offset + section.Size);
+			}
+
+			if (this->OwnedText.size() > UINT32_MAX) { throw "Image too large for SuffixIndex."; }
+
+			this->OwnedSuffixes.resize(this->OwnedText.size());
+
+			uint64_t textStart = 0;
+
+			for (const Range& section : this->Sections)
+			{
+				BuildSuffixArray(this->OwnedText.data(), textStart, section.Size, this->OwnedSuffixes.data() + textStart);
+				textStart += section.Size;
+			}
+
+			this->Text     = this->OwnedText.data();
+			this->Suffixes = this->OwnedSuffixes.data();
+			this->TextSize = this->OwnedText.size();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsValid:
+		/// 	Returns true if the index was built or loaded.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsValid() const
+		{
+			return this->Text != nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Count:
+		/// 	Returns the amount of matches of the pattern, stopping early once aLimit is reached.
+		///----------------------------------------------------------------------------------------------------
+		inline uint64_t Count(const Pattern& aPattern, uint64_t aLimit = UINT64_MAX) const
+		{
+			uint64_t count = 0;
+
+			this->Query(aPattern, [&count, aLimit](uint64_t)
+			{
+				return ++count < aLimit;
+			}, [&count, aLimit](uint64_t aIntervalSize)
+			{
+				count += aIntervalSize;
+				return count < aLimit;
+			});
+
+			return std::min(count, aLimit);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsUnique:
+		/// 	Returns true if the pattern matches exactly once.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsUnique(const Pattern& aPattern) const
+		{
+			return this->Count(aPattern, 2) == 1;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindAll:
+		/// 	Returns the image relative offsets of all matches, in ascending order.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<uint64_t> FindAll(const Pattern& aPattern) const
+		{
+			std::vector<uint64_t> offsets;
+
+			this->Query(aPattern, [&offsets](uint64_t aOffset)
+			{
+				offsets.push_back(aOffset);
+				return true;
+			});
+
+			std::sort(offsets.begin(), offsets.end());
+
+			return offsets;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Save:
+		/// 	Writes the index to disk, so it can be mapped with Load instead of being rebuilt.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Save(const char* aPath) const
+		{
+			if (!this->IsValid()) { return false; }
+
+			FILE* file = fopen(aPath, "wb");
+
+			if (!file) { return false; }
+
+			Header         header{ MAGIC, VERSION, this->Fingerprint, this->Sections.size(), this->TextSize };
+			const uint8_t  padding[4]{};
+			uint64_t       paddingSize = (4 - (sizeof(Header) + this->Sections.size() * sizeof(Range) + this->TextSize) % 4) % 4;
+
+			bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+			success = success && fwrite(this->Sections.data(), sizeof(Range), this->Sections.size(), file) == this->Sections.size();
+			success = success && fwrite(this->Text, 1, this->TextSize, file) == this->TextSize;
+			success = success && fwrite(padding, 1, paddingSize, file) == paddingSize;
+			success = success && fwrite(this->Suffixes, sizeof(uint32_t), this->TextSize, file) == this->TextSize;
+
+			return fclose(file) == 0 && success;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Load:
+		/// 	Maps an index saved with Save. Nothing is copied except the section table, the suffixes are
+		/// 	only bounds checked.
+		/// 	If aImageBase is given, the index is bound to it and rejected if it was built from a
+		/// 	different image. Pass aIsMapped and aSize as to the ctor if it is an image file.
+		/// 	Without an image, offsets can be queried but not scanned.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Load(const char* aPath, const void* aImageBase = nullptr, bool aIsMapped = true, uint64_t aSize = UINT64_MAX)
+		{
+			*this = SuffixIndex();
+
+			if (!this->File.Open(aPath)) { return false; }
+
+			const uint8_t* data = this->File.Data;
+
+			Header header;
+			if (this->File.Size < sizeof(header)) { return false; }
+			memcpy(&header, data, sizeof(header));
+
+			if (header.Magic != MAGIC || header.Version != VERSION) { return false; }
+			if (header.SectionCount > this->File.Size || header.TextSize > this->File.Size) { return false; }
+
+			uint64_t textOffset     = sizeof(Header) + header.SectionCount * sizeof(Range);
+			uint64_t suffixesOffset = (textOffset + header.TextSize + 3) & ~3ULL;
+
+			if (suffixesOffset + header.TextSize * sizeof(uint32_t) != this->File.Size) { return false; }
+
+			std::vector<Range> sections(header.SectionCount);
+			memcpy(sections.data(), data + sizeof(Header), sections.size() * sizeof(Range));
+
+			uint64_t textSize = 0;
+
+			for (const Range& section : sections)
+			{
+				if (section.Size > header.TextSize - textSize) { return false; }
+				textSize += section.Size;
+			}
+
+			if (textSize != header.TextSize) { return false; }
+
+			/* The section table is only hashed once it is known to be the image's own. Reject indices
+			   of a different image or build. */
+			if (aImageBase)
+			{
+				if (aSize < 0x400 || !SameSections(sections, GetExecutableSections(aImageBase, aIsMapped, aSize))) { return false; }
+				if (FingerprintModule(aImageBase, sections) != header.Fingerprint) { return false; }
+			}
+
+			/* Every suffix starts inside the section it was sorted with. */
+			const uint32_t* suffixes  = (const uint32_t*)(data + suffixesOffset);
+			uint64_t        textStart = 0;
+
+			for (const Range& section : sections)
+			{
+				for (uint64_t i = textStart; i < textStart + section.Size; i++)
+				{
+					if (suffixes[i] < textStart || suffixes[i] - textStart >= section.Size) { return false; }
+				}
+
+				textStart += section.Size;
+			}
+
+			this->ImageBase   = (PBYTE)aImageBase;
+			this->Fingerprint = header.Fingerprint;
+			this->Sections    = std::move(sections);
+			this->Text        = data + textOffset;
+			this->Suffixes    = suffixes;
+			this->TextSize    = header.TextSize;
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Query:
+		/// 	Invokes aOnMatch(uint64_t aOffset) for every match. Stops once the callback returns false.
+		/// 	If aOnInterval(uint64_t aSize) is given, whole suffix intervals that need no per match
+		/// 	filtering are reported through it instead, without enumerating them.
+		///----------------------------------------------------------------------------------------------------
+		template <typename OnMatch, typename OnInterval = std::nullptr_t>
+		inline void Query(const Pattern& aPattern, OnMatch aOnMatch, OnInterval aOnInterval = nullptr) const
+		{
+			if (!this->IsValid() || aPattern.Size == 0) { return; }
+
+			/* Leading and trailing wildcards only constrain the position, they are checked per match. */
+			uint64_t lead  = 0;
+			uint64_t trail = aPattern.Size;
+
+			while (lead < trail && aPattern[lead].IsWildcard) { lead++; }
+			while (trail > lead && aPattern[trail - 1].IsWildcard) { trail--; }
+
+			/* Only wildcards, every position that fits matches. */
+			if (lead == trail) { lead = trail = 0; }
+
+			uint64_t textStart = 0;
+			bool     proceed   = true;
+
+			for (const Range& section : this->Sections)
+			{
+				if (!proceed) { break; }
+
+				uint64_t sectionStart = textStart;
+				uint64_t sectionEnd   = textStart + section.Size;
+				textStart = sectionEnd;
+
+				if (section.Size < aPattern.Size) { continue; }
+
+				auto onRange = [&](uint64_t aLo, uint64_t aHi)
+				{
+					if (lead == 0 && trail == aPattern.Size && !std::is_same<OnInterval, std::nullptr_t>::value)
+					{
+						proceed = InvokeInterval(aOnInterval, aHi - aLo);
+						return proceed;
+					}
+
+					for (uint64_t i = aLo; i < aHi && proceed; i++)
+					{
+						uint64_t position = this->Suffixes[i];
+
+						if (position < sectionStart + lead || position - lead + aPattern.Size > sectionEnd)
+						{
+							continue;
+						}
+
+						proceed = aOnMatch(section.Offset + (position - lead - sectionStart));
+					}
+
+					return proceed;
+				};
+
+				if (lead == trail)
+				{
+					onRange(sectionStart, sectionEnd);
+				}
+				else
+				{
+					this->Search(aPattern.Data() + lead, trail - lead, 0, sectionStart, sectionEnd, sectionEnd, onRange);
+				}
+			}
+		}
+
+	private:
+		std::vector<uint8_t>  OwnedText;
+		std::vector<uint32_t> OwnedSuffixes;
+		MappedFile            File;
+
+		template <typename Fn>
+		static inline bool InvokeInterval(Fn& aOnInterval, uint64_t aSize) { return aOnInterval(aSize); }
+		static inline bool InvokeInterval(std::nullptr_t, uint64_t) { return true; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// CharAt:
+		/// 	Returns the byte at depth aDepth of a suffix, or -1 if the suffix is shorter.
+		///----------------------------------------------------------------------------------------------------
+		inline int32_t CharAt(uint64_t aSuffix, uint64_t aDepth, uint64_t aTextEnd) const
+		{
+			uint64_t position = this->Suffixes[aSuffix] + aDepth;
+			return position < aTextEnd ? this->Text[position] : -1;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// LowerBound:
+		/// 	Returns the first suffix in [aLo, aHi) with a byte >= aValue at depth aDepth.
+		///----------------------------------------------------------------------------------------------------
+		inline uint64_t LowerBound(uint64_t aLo, uint64_t aHi, uint64_t aDepth, int32_t aValue, uint64_t aTextEnd) const
+		{
+			while (aLo < aHi)
+			{
+				uint64_t mid = aLo + (aHi - aLo) / 2;
+
+				if (this->CharAt(mid, aDepth, aTextEnd) < aValue) { aLo = mid + 1; }
+				else                                              { aHi = mid; }
+			}
+
+			return aLo;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Search:
+		/// 	Narrows the suffix interval [aLo, aHi) one pattern byte at a time.
+		/// 	Returns false if the search was stopped.
+		///----------------------------------------------------------------------------------------------------
+		template <typename Fn>
+		inline bool Search(const Byte* aBytes, uint64_t aSize, uint64_t aDepth, uint64_t aLo, uint64_t aHi, uint64_t aTextEnd, Fn& aOnRange) const
+		{
+			if (aDepth == aSize)
+			{
+				return aOnRange(aLo, aHi);
+			}
+
+			if (aBytes[aDepth].IsExact())
+			{
+				int32_t  value = aBytes[aDepth].Value;
+				uint64_t lo    = this->LowerBound(aLo, aHi, aDepth, value, aTextEnd);
+				uint64_t hi    = this->LowerBound(lo, aHi, aDepth, value + 1, aTextEnd);
+
+				return lo == hi || this->Search(aBytes, aSize, aDepth + 1, lo, hi, aTextEnd, aOnRange);
+			}
+
+			/* Suffixes ending before this depth sort first, skip them. */
+			uint64_t lo = this->LowerBound(aLo, aHi, aDepth, 0, aTextEnd);
+
+			while (lo < aHi)
+			{
+				int32_t  value = this->CharAt(lo, aDepth, aTextEnd);
+				uint64_t hi    = this->LowerBound(lo, aHi, aDepth, value + 1, aTextEnd);
+
+				/* Wildcards take every value, partial masks only the matching ones. */
+				if (aBytes[aDepth].Matches((uint8_t)value) && !this->Search(aBytes, aSize, aDepth + 1, lo, hi, aTextEnd, aOnRange))
+				{
+					return false;
+				}
+
+				lo = hi;
+			}
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// BuildSuffixArray:
+		/// 	Prefix doubling with radix sort. Writes the sorted positions of aText[aStart, aStart + aSize).
+		///----------------------------------------------------------------------------------------------------
+		static inline void BuildSuffixArray(const uint8_t* aText, uint64_t aStart, uint64_t aSize, uint32_t* aOut)
+		{
+			if (aSize == 0) { return; }
+
+			uint32_t n = (uint32_t)aSize;
+
+			std::vector<uint32_t> rank(n);
+			std::vector<uint32_t> nextRank(n);
+			std::vector<uint32_t> order(n);
+			std::vector<uint32_t> counts(std::max<uint32_t>(n, 256) + 2);
+
+			/* Sort by the first byte. Rank 0 is reserved for "past the end". */
+			for (uint32_t i = 0; i < n; i++) { counts[aText[aStart + i] + 1]++; }
+			for (uint32_t c = 1; c < 258; c++) { counts[c] += counts[c - 1]; }
+			for (uint32_t i = 0; i < n; i++) { aOut[counts[aText[aStart + i]]++] = i; }
+			for (uint32_t i = 0; i < n; i++) { rank[i] = aText[aStart + i] + 1u; }
+
+			uint32_t maxRank = 256;
+
+			for (uint32_t k = 1; ; k <<= 1)
+			{
+				/* Order by the second key: suffixes without a second half first, then by rank of i + k. */
+				uint32_t idx = 0;
+				for (uint32_t i = n - std::min(k, n); i < n; i++) { order[idx++] = i; }
+				for (uint32_t i = 0; i < n; i++) { if (aOut[i] >= k) { order[idx++] = aOut[i] - k; } }
+
+				/* Stable counting sort by the first key. */
+				std::fill(counts.begin(), counts.begin() + maxRank + 2, 0);
+				for (uint32_t i = 0; i < n; i++) { counts[rank[i] + 1]++; }
+				for (uint32_t c = 1; c <= maxRank + 1; c++) { counts[c] += counts[c - 1]; }
+				for (uint32_t i = 0; i < n; i++) { aOut[counts[rank[order[i]]]++] = order[i]; }
+
+				/* Re-rank by the pair. */
+				auto second = [&](uint32_t aPos) { return aPos + k < n ? rank[aPos + k] : 0u; };
+
+				nextRank[aOut[0]] = 1;
+				for (uint32_t i = 1; i < n; i++)
+				{
+					bool same = rank[aOut[i]] == rank[aOut[i - 1]] && second(aOut[i]) == second(aOut[i - 1]);
+					nextRank[aOut[i]] = nextRank[aOut[i - 1]] + (same ? 0 : 1);
+				}
+
+				rank.swap(nextRank);
+				maxRank = rank[aOut[n - 1]];
+
+				if (maxRank == n || k >= n) { break; }
+			}
+
+			/* Positions are relative to the whole text. */
+			for (uint32_t i = 0; i < n; i++) { aOut[i] += (uint32_t)aStart; }
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// PageSummary Struct
+	/// 	Snapshot of which byte values, and which adjacent byte pairs, occur in each 4 KiB page.
+	/// 	Byte values are stored exactly as a 256 bit set. Pairs are stored in a 1024 bit Bloom filter,
+	/// 	the pair crossing into the next page is recorded in the earlier page.
+	/// 	The summary is not updated, build it for memory that doesn't change, e.g. code sections.
+	///----------------------------------------------------------------------------------------------------
+	struct PageSummary
+	{
+		static constexpr uint64_t PAGE_BYTES = 0x1000;
+		static constexpr uint32_t PAIR_BITS  = 1024;
+
+		struct Region
+		{
+			PBYTE    Base;
+			uint64_t Size;
+			uint64_t FirstPage; /* index into the page arrays */
+		};
+
+		struct ByteSet
+		{
+			uint64_t Bits[4];
+		};
+
+		struct PairFilter
+		{
+			uint64_t Bits[PAIR_BITS / 64];
+		};
+
+		std::vector<Region>     Regions;
+		std::vector<ByteSet>    Bytes;
+		std::vector<PairFilter> Pairs;
+		bool                    HasPairs = true;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Summarizes all executable regions of the process.
+		///----------------------------------------------------------------------------------------------------
+		inline explicit PageSummary(bool aWithPairs = true)
+			: HasPairs(aWithPairs)
+		{
+			ForEachRegion(nullptr, [this](PBYTE aBase, uint64_t aSize)
+			{
+				this->Add(aBase, aSize);
+				return true;
+			});
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Summarizes a single memory range.
+		///----------------------------------------------------------------------------------------------------
+		inline PageSummary(PBYTE aBase, uint64_t aSize, bool aWithPairs = true)
+			: HasPairs(aWithPairs)
+		{
+			this->Add(aBase, aSize);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Add:
+		/// 	Summarizes another memory range.
+		///----------------------------------------------------------------------------------------------------
+		inline void Add(PBYTE aBase, uint64_t aSize)
+		{
+			if (!aBase || aSize == 0) { return; }
+
+			uint64_t pageCount = (aSize + PAGE_BYTES - 1) / PAGE_BYTES;
+
+			this->Regions.push_back(Region{ aBase, aSize, this->Bytes.size() });
+			this->Bytes.resize(this->Bytes.size() + pageCount, ByteSet{});
+			if (this->HasPairs) { this->Pairs.resize(this->Pairs.size() + pageCount, PairFilter{}); }
+
+			ByteSet*    bytes = &this->Bytes[this->Regions.back().FirstPage];
+			PairFilter* pairs = this->HasPairs ? &this->Pairs[this->Regions.back().FirstPage] : nullptr;
+
+			for (uint64_t i = 0; i < aSize; i++)
+			{
+				uint64_t page = i / PAGE_BYTES;
+
+				bytes[page].Bits[aBase[i] >> 6] |= 1ULL << (aBase[i] & 63);
+
+				if (pairs && i + 1 < aSize)
+				{
+					uint32_t h1 = 0;
+					uint32_t h2 = 0;
+					HashPair(aBase[i], aBase[i + 1], h1, h2);
+
+					pairs[page].Bits[h1 >> 6] |= 1ULL << (h1 & 63);
+					pairs[page].Bits[h2 >> 6] |= 1ULL << (h2 & 63);
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ForEachCandidateRun:
+		/// 	Invokes aCallback(PBYTE aBase, uint64_t aSize) for each run of pages that may contain a
+		/// 	match start. The passed range includes the tail a match may reach into.
+		/// 	Stops once the callback returns false.
+		///----------------------------------------------------------------------------------------------------
+		template <typename Fn>
+		inline void ForEachCandidateRun(const Pattern& aPattern, Fn aCallback) const
+		{
+			if (aPattern.Size == 0) { return; }
+
+			ByteSet    required{};
+			PairFilter requiredPairs{};
+			bool       anyPairs = false;
+
+			for (uint64_t j = 0; j < aPattern.Size; j++)
+			{
+				const Byte& b = aPattern[j];
+
+				if (!b.IsExact()) { continue; }
+
+				required.Bits[b.Value >> 6] |= 1ULL << (b.Value & 63);
+
+				if (this->HasPairs && j + 1 < aPattern.Size && aPattern[j + 1].IsExact())
+				{
+					uint32_t h1 = 0;
+					uint32_t h2 = 0;
+					HashPair(b.Value, aPattern[j + 1].Value, h1, h2);
+
+					requiredPairs.Bits[h1 >> 6] |= 1ULL << (h1 & 63);
+					requiredPairs.Bits[h2 >> 6] |= 1ULL << (h2 & 63);
+					anyPairs = true;
+				}
+			}
+
+			/* A match starting in a page reaches at most this many pages further. */
+			uint64_t span = (PAGE_BYTES - 1 + aPattern.Size - 1) / PAGE_BYTES;
+
+			for (const Region& region : this->Regions)
+			{
+				if (aPattern.Size > region.Size) { continue; }
+
+				uint64_t pageCount = (region.Size + PAGE_BYTES - 1) / PAGE_BYTES;
+				uint64_t runStart  = UINT64_MAX;
+
+				for (uint64_t page = 0; page <= pageCount; page++)
+				{
+					bool candidate = page < pageCount && this->MayContain(region, page, std::min(page + span, pageCount - 1), required, anyPairs ? &requiredPairs : nullptr);
+
+					if (candidate && runStart == UINT64_MAX)
+					{
+						runStart = page;
+					}
+					else if (!candidate && runStart != UINT64_MAX)
+					{
+						uint64_t begin = runStart * PAGE_BYTES;
+						uint64_t end   = std::min(page * PAGE_BYTES + aPattern.Size - 1, region.Size);
+
+						if (!aCallback(region.Base + begin, end - begin)) { return; }
+
+						runStart = UINT64_MAX;
+					}
+				}
+			}
+		}
+
+	private:
+		static inline void HashPair(uint8_t aFirst, uint8_t aSecond, uint32_t& aHash1, uint32_t& aHash2)
+		{
+			uint32_t key = ((uint32_t)aFirst << 8) | aSecond;
+
+			aHash1 = (key * 2654435761u) >> 22;
+			aHash2 = ((key ^ 0x5BD1) * 0x85EBCA6Bu) >> 22;
+		}
+
+		inline bool MayContain(const Region& aRegion, uint64_t aFirst, uint64_t aLast, const ByteSet& aRequired, const PairFilter* aRequiredPairs) const
+		{
+			ByteSet present{};
+
+			for (uint64_t page = aFirst; page <= aLast; page++)
+			{
+				for (int w = 0; w < 4; w++) { present.Bits[w] |= this->Bytes[aRegion.FirstPage + page].Bits[w]; }
+			}
+
+			for (int w = 0; w < 4; w++)
+			{
+				if ((present.Bits[w] & aRequired.Bits[w]) != aRequired.Bits[w]) { return false; }
+			}
+
+			if (!aRequiredPairs) { return true; }
+
+			PairFilter presentPairs{};
+
+			for (uint64_t page = aFirst; page <= aLast; page++)
+			{
+				for (uint32_t w = 0; w < PAIR_BITS / 64; w++) { presentPairs.Bits[w] |= this->Pairs[aRegion.FirstPage + page].Bits[w]; }
+			}
+
+			for (uint32_t w = 0; w < PAIR_BITS / 64; w++)
+			{
+				if ((presentPairs.Bits[w] & aRequiredPairs->Bits[w]) != aRequiredPairs->Bits[w]) { return false; }
+			}
+
+			return true;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// EXrefKind Enumeration
+	///----------------------------------------------------------------------------------------------------
+	enum class EXrefKind
+	{
+		call,   /* E8 rel32 */
+		jmp,    /* E9 rel32 */
+		jcc,    /* 0F 8x rel32 */
+		riprel  /* ModRM with mod 00 and rm 101, e.g. lea/mov reg, [rip + disp32] */
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Xref Struct
+	///----------------------------------------------------------------------------------------------------
+	struct Xref
+	{
+		PBYTE     Address; /* address of the rel32 displacement */
+		EXrefKind Kind;
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// XrefScan Struct
+	/// 	Finds all code referencing a target address through a rel32 displacement, in one pass.
+	/// 	A position references the target if its displacement + position + 4 equals the target.
+	/// 	Instructions with an immediate after the displacement are relative to a later address and
+	/// 	are not found, e.g. cmp [rip + disp32], imm8.
+	///----------------------------------------------------------------------------------------------------
+	struct XrefScan
+	{
+		const void* Target = nullptr;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		constexpr XrefScan(const void* aTarget) : Target(aTarget) {}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans all executable regions and returns the referencing sites in ascending order.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<Xref> Scan() const
+		{
+			std::vector<Xref> xrefs;
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				this->ScanRange(aBase, aSize, xrefs);
+				return true;
+			});
+
+			return xrefs;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanRange:
+		/// 	Scans the given memory range and appends the referencing sites in ascending order.
+		///----------------------------------------------------------------------------------------------------
+		inline void ScanRange(PBYTE aBase, uint64_t aSize, std::vector<Xref>& aOut) const
+		{
+			if (aSize < 5) { return; }
+
+			/* Only positions within +-2 GiB of the target can reference it. */
+			uintptr_t target = (uintptr_t)this->Target;
+			uintptr_t base   = (uintptr_t)aBase;
+
+			int64_t first = (int64_t)(target - base) - 4 - INT32_MAX;
+			int64_t last  = (int64_t)(target - base) - 4 - INT32_MIN;
+
+			/* A position needs an opcode byte before it and four displacement bytes. */
+			uint64_t lo = (uint64_t)std::max<int64_t>(first, 1);
+			uint64_t hi = (uint64_t)std::min<int64_t>(last, (int64_t)aSize - 4);
+
+			if (first > (int64_t)aSize || last < 1 || lo > hi) { return; }
+
+			size_t count = aOut.size();
+
+#ifdef MEMTOOLS_HAS_AVX512
+			if (SupportsAVX512BW())
+			{
+				ScanAVX512(aBase, lo, hi, target, aOut);
+			}
+			else
+#endif
+			{
+				for (uint64_t i = lo; i <= hi; i++)
+				{
+					int32_t disp;
+					memcpy(&disp, &aBase[i], sizeof(disp));
+
+					if ((uintptr_t)(aBase + i + 4 + disp) == target)
+					{
+						Classify(aBase, i, aOut);
+					}
+				}
+			}
+
+			std::sort(aOut.begin() + count, aOut.end(), [](const Xref& aLhs, const Xref& aRhs)
+			{
+				return aLhs.Address < aRhs.Address;
+			});
+		}
+
+	private:
+		///----------------------------------------------------------------------------------------------------
+		/// Classify:
+		/// 	Appends the position if the bytes before it form a known rel32 instruction.
+		///----------------------------------------------------------------------------------------------------
+		static inline void Classify(PBYTE aBase, uint64_t aPosition, std::vector<Xref>& aOut)
+		{
+			uint8_t op = aBase[aPosition - 1];
+
+			if (op == 0xE8)
+			{
+				aOut.push_back(Xref{ &aBase[aPosition], EXrefKind::call });
+			}
+			else if (op == 0xE9)
+			{
+				aOut.push_back(Xref{ &aBase[aPosition], EXrefKind::jmp });
+			}
+			else if (aPosition >= 2 && aBase[aPosition - 2] == 0x0F && (op & 0xF0) == 0x80)
+			{
+				aOut.push_back(Xref{ &aBase[aPosition], EXrefKind::jcc });
+			}
+			else if ((op & 0xC7) == 0x05)
+			{
+				aOut.push_back(Xref{ &aBase[aPosition], EXrefKind::riprel });
+			}
+		}
+
+#ifdef MEMTOOLS_HAS_AVX512
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAVX512:
+		/// 	Compares 16 displacements at a stride of 4 bytes, once for each of the 4 byte phases,
+		/// 	so 64 positions per iteration. The expected displacement of each lane is target - lane - 4.
+		///----------------------------------------------------------------------------------------------------
+		MEMTOOLS_TARGET_AVX512BW static inline void ScanAVX512(PBYTE aBase, uint64_t aLo, uint64_t aHi, uintptr_t aTarget, std::vector<Xref>& aOut)
+		{
+			const __m512i laneOffsets = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60);
+
+			for (uint64_t i = aLo; i <= aHi; i += 64)
+			{
+				for (uint64_t phase = 0; phase < 4 && i + phase <= aHi; phase++)
+				{
+					uint64_t  start = i + phase;
+					uint64_t  lanes = (aHi - start) / 4 + 1;
+					__mmask16 valid = lanes >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << lanes) - 1);
+
+					__m512i expected = _mm512_sub_epi32(_mm512_set1_epi32((int32_t)(uint32_t)(aTarget - (uintptr_t)&aBase[start] - 4)), laneOffsets);
+					__m512i disps    = _mm512_maskz_loadu_epi32(valid, &aBase[start]);
+
+					uint32_t matches = _mm512_mask_cmpeq_epi32_mask(valid, disps, expected);
+
+					while (matches)
+					{
+						Classify(aBase, start + 4 * _tzcnt_u32(matches), aOut);
+						matches &= matches - 1;
+					}
+				}
+			}
+		}
+#endif
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// StringIndex Struct
+	/// 	Maps the string literals in the read-only sections of a module to the RIP-relative
+	/// 	instructions referencing them, so code can be located by a string without a pattern scan.
+	/// 	Literals are NUL-terminated runs of printable ASCII, or of printable UTF-16 units.
+	/// 	References into the middle of a literal (merged string tails) are keyed by that tail.
+	///----------------------------------------------------------------------------------------------------
+	struct StringIndex
+	{
+		struct Literal
+		{
+			PBYTE    Address;
+			uint32_t Length;  /* in characters, without terminator */
+			bool     IsWide;
+		};
+
+		std::vector<Range>   ReadOnlySections;
+		std::vector<Literal> Literals;     /* ASCII, sorted by address */
+		std::vector<Literal> WideLiterals; /* UTF-16, sorted by address */
+
+		std::unordered_map<std::string,    std::vector<Xref>> References;
+		std::unordered_map<std::u16string, std::vector<Xref>> WideReferences;
+
+		StringIndex() = default;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Extracts the literals of a loaded module and sweeps its code once for references.
+		///----------------------------------------------------------------------------------------------------
+		inline explicit StringIndex(const void* aModuleBase, uint32_t aMinLength = 1)
+		{
+			if (!aModuleBase) { throw "Module base is nullptr."; }
+
+			PBYTE module = (PBYTE)aModuleBase;
+
+			this->ReadOnlySections = GetSections(aModuleBase, ESectionType::readonly);
+
+			for (const Range& section : this->ReadOnlySections)
+			{
+				ExtractLiterals<false>(module + section.Offset, section.Size, aMinLength, this->Literals);
+				ExtractLiterals<true>(module + section.Offset, section.Size & ~1ULL, aMinLength, this->WideLiterals);
+			}
+
+			for (const Range& section : GetExecutableSections(aModuleBase))
+			{
+				PBYTE code = module + section.Offset;
+
+				for (uint64_t i = 1; i + 4 <= section.Size; i++)
+				{
+					/* ModRM with mod 00 and rm 101 is [rip + disp32]. */
+					if ((code[i - 1] & 0xC7) != 0x05) { continue; }
+
+					int32_t disp;
+					memcpy(&disp, &code[i], sizeof(disp));
+
+					this->AddReference(this->Literals, &code[i], &code[i] + 4 + disp);
+					this->AddReference(this->WideLiterals, &code[i], &code[i] + 4 + disp);
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindReferences:
+		/// 	Returns the RIP-relative displacements referencing the string, in ascending order.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<Xref> FindReferences(const char* aString) const
+		{
+			auto it = this->References.find(aString);
+			return it != this->References.end() ? it->second : std::vector<Xref>{};
+		}
+
+		inline std::vector<Xref> FindReferences(const wchar_t* aString) const
+		{
+			std::u16string key;
+			for (; *aString; aString++) { key.push_back((char16_t)*aString); }
+
+			auto it = this->WideReferences.find(key);
+			return it != this->WideReferences.end() ? it->second : std::vector<Xref>{};
+		}
+
+	private:
+		///----------------------------------------------------------------------------------------------------
+		/// AddReference:
+		/// 	Records a reference if the target lies within a literal of the list.
+		/// 	Literals of one list don't overlap, so only the last one starting at or before the target
+		/// 	can contain it.
+		///----------------------------------------------------------------------------------------------------
+		inline void AddReference(const std::vector<Literal>& aLiterals, PBYTE aSite, PBYTE aTarget)
+		{
+			auto it = std::upper_bound(aLiterals.begin(), aLiterals.end(), aTarget, [](PBYTE aAddress, const Literal& aLiteral)
+			{
+				return aAddress < aLiteral.Address;
+			});
+
+			if (it != aLiterals.begin())
+			{
+				const Literal& literal = *--it;
+
+				uint64_t unit = literal.IsWide ? 2 : 1;
+				uint64_t skip = (uint64_t)(aTarget - literal.Address);
+
+				if (skip % unit != 0 || skip / unit >= literal.Length) { return; }
+
+				if (literal.IsWide)
+				{
+					std::u16string key((size_t)(literal.Length - skip / unit), u'\0');
+					memcpy(&key[0], aTarget, key.size() * sizeof(char16_t));
+					this->WideReferences[key].push_back(Xref{ aSite, EXrefKind::riprel });
+				}
+				else
+				{
+					this->References[std::string((const char*)aTarget, literal.Length - skip)].push_back(Xref{ aSite, EXrefKind::riprel });
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsPrintable:
+		/// 	Printable ASCII, tab, line feed and carriage return.
+		///----------------------------------------------------------------------------------------------------
+		static inline bool IsPrintable(uint16_t aChar)
+		{
+			return (aChar >= 0x20 && aChar <= 0x7E) || aChar == '\t' || aChar == '\n' || aChar == '\r';
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ClassifyBlock:
+		/// 	Sets bit i of aPrintable / aTerminator if unit i of the block is printable / zero.
+		/// 	A block is 64 bytes, i.e. 64 narrow or 32 wide units.
+		///----------------------------------------------------------------------------------------------------
+		template <bool Wide>
+		static inline void ClassifyBlock(const uint8_t* aData, uint64_t aUnits, uint64_t& aPrintable, uint64_t& aTerminator)
+		{
+			aPrintable  = 0;
+			aTerminator = 0;
+
+			for (uint64_t i = 0; i < aUnits; i++)
+			{
+				uint16_t c = aData[i];
+				if (Wide) { memcpy(&c, &aData[i * 2], sizeof(c)); }
+
+				aPrintable  |= (uint64_t)IsPrintable(c) << i;
+				aTerminator |= (uint64_t)(c == 0) << i;
+			}
+		}
+
+#ifdef MEMTOOLS_HAS_AVX512
+		template <bool Wide>
+		MEMTOOLS_TARGET_AVX512BW static inline void ClassifyBlockAVX512(const uint8_t* aData, uint64_t aUnits, uint64_t& aPrintable, uint64_t& aTerminator)
+		{
+			uint64_t valid = aUnits >= 64 ? ~0ULL : (1ULL << aUnits) - 1;
+
+			if (Wide)
+			{
+				__m512i units = _mm512_maskz_loadu_epi16((__mmask32)valid, aData);
+
+				__mmask32 inRange  = _mm512_cmp_epu16_mask(_mm512_sub_epi16(units, _mm512_set1_epi16(0x20)), _mm512_set1_epi16(0x5E), _MM_CMPINT_LE);
+				__mmask32 tab      = _mm512_cmpeq_epi16_mask(units, _mm512_set1_epi16('\t'));
+				__mmask32 lineFeed = _mm512_cmpeq_epi16_mask(units, _mm512_set1_epi16('\n'));
+				__mmask32 carriage = _mm512_cmpeq_epi16_mask(units, _mm512_set1_epi16('\r'));
+
+				aPrintable  = (uint64_t)(inRange | tab | lineFeed | carriage) & valid;
+				aTerminator = (uint64_t)_mm512_testn_epi16_mask(units, units) & valid;
+			}
+			else
+			{
+				__m512i bytes = _mm512_maskz_loadu_epi8(valid, aData);
+
+				__mmask64 inRange  = _mm512_cmp_epu8_mask(_mm512_sub_epi8(bytes, _mm512_set1_epi8(0x20)), _mm512_set1_epi8(0x5E), _MM_CMPINT_LE);
+				__mmask64 tab      = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\t'));
+				__mmask64 lineFeed = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\n'));
+				__mmask64 carriage = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\r'));
+
+				aPrintable  = (inRange | tab | lineFeed | carriage) & valid;
+				aTerminator = _mm512_testn_epi8_mask(bytes, bytes) & valid;
+			}
+		}
+#endif
+
+		///----------------------------------------------------------------------------------------------------
+		/// ExtractLiterals:
+		/// 	Appends every run of at least aMinLength printable units followed by a zero unit.
+		/// 	Classifies 64 bytes at a time, runs are found with bit operations on the masks.
+		///----------------------------------------------------------------------------------------------------
+		template <bool Wide>
+		static inline void ExtractLiterals(PBYTE aData, uint64_t aSize, uint32_t aMinLength, std::vector<Literal>& aOut)
+		{
+			const uint64_t unitSize      = Wide ? 2 : 1;
+			const uint64_t unitsPerBlock = 64 / unitSize;
+			const uint64_t unitCount     = aSize / unitSize;
+
+			uint64_t runStart      = 0; /* unit after the last non-printable unit */
+			uint64_t lastPrintable = 0; /* whether the last unit of the previous block was printable */
+
+			for (uint64_t block = 0; block < unitCount; block += unitsPerBlock)
+			{
+				uint64_t units       = std::min(unitsPerBlock, unitCount - block);
+				uint64_t printable   = 0;
+				uint64_t terminators = 0;
+
+#ifdef MEMTOOLS_HAS_AVX512
+				if (SupportsAVX512BW())
+				{
+					ClassifyBlockAVX512<Wide>(&aData[block * unitSize], units, printable, terminators);
+				}
+				else
+#endif
+				{
+					ClassifyBlock<Wide>(&aData[block * unitSize], units, printable, terminators);
+				}
+
+				uint64_t valid       = units >= 64 ? ~0ULL : (1ULL << units) - 1;
+				uint64_t nonPrinting = ~printable & valid;
+
+				/* Terminators directly after a printable unit end a run. */
+				uint64_t ends = terminators & ((printable << 1) | lastPrintable);
+
+				while (ends)
+				{
+					uint64_t end   = CountTrailingZeros(ends);
+					uint64_t below = nonPrinting & ((1ULL << end) - 1);
+					uint64_t start = below ? block + (63 - CountLeadingZeros(below)) + 1 : runStart;
+
+					uint64_t length = block + end - start;
+
+					if (length >= aMinLength && length <= UINT32_MAX)
+					{
+						aOut.push_back(Literal{ &aData[start * unitSize], (uint32_t)length, Wide });
+					}
+
+					ends &= ends - 1;
+				}
+
+				if (nonPrinting)
+				{
+					runStart = block + (63 - CountLeadingZeros(nonPrinting)) + 1;
+				}
+
+				lastPrintable = (printable >> (units - 1)) & 1;
+			}
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// DecodedInstruction Struct
+	/// 	Layout of a decoded x86-64 instruction. Offsets are relative to the instruction start.
+	///----------------------------------------------------------------------------------------------------
+	struct DecodedInstruction
+	{
+		uint8_t Length        = 0;
+		uint8_t OpcodeOffset  = 0;     /* offset of the opcode byte, after prefixes and escapes */
+		bool    HasModRM      = false;
+		uint8_t ModRMOffset   = 0;
+		uint8_t DispOffset    = 0;
+		uint8_t DispSize      = 0;
+		uint8_t ImmOffset     = 0;
+		uint8_t ImmSize       = 0;
+		bool    IsRipRelative = false; /* displacement is relative to the next instruction */
+		bool    IsBranch      = false; /* immediate is a rel8 / rel32 branch offset */
+	};
+
+	namespace decoder
+	{
+		/* Table entry: low nibble flags, high nibble immediate kind. */
+		constexpr uint8_t M = 0x01; /* has ModRM */
+		constexpr uint8_t P = 0x02; /* legacy prefix */
+		constexpr uint8_t X = 0x04; /* invalid in 64-bit mode */
+
+		constexpr uint8_t IB     = 0x10; /* imm8 */
+		constexpr uint8_t IW     = 0x20; /* imm16 */
+		constexpr uint8_t IZ     = 0x30; /* imm16 / imm32 by operand size */
+		constexpr uint8_t IV     = 0x40; /* imm16 / imm32 / imm64 by operand size */
+		constexpr uint8_t IWB    = 0x50; /* imm16 + imm8 (enter) */
+		constexpr uint8_t MOFFS  = 0x60; /* moffs64 / moffs32 by address size */
+		constexpr uint8_t REL8   = 0x70;
+		constexpr uint8_t REL32  = 0x80;
+		constexpr uint8_t GRP3B  = 0x90; /* imm8 if ModRM.reg is 0 or 1 (test) */
+		constexpr uint8_t GRP3Z  = 0xA0; /* imm16 / imm32 if ModRM.reg is 0 or 1 (test) */
+
+		/* One-byte opcode map. REX, VEX, EVEX and 0F are handled by the decoder. */
+		constexpr uint8_t OneByte[256] =
+		{
+			/*        0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F */
+			/* 0 */   M,      M,      M,      M,      IB,     IZ,     X,      X,      M,      M,      M,      M,      IB,     IZ,     X,      0,
+			/* 1 */   M,      M,      M,      M,      IB,     IZ,     X,      X,      M,      M,      M,      M,      IB,     IZ,     X,      X,
+			/* 2 */   M,      M,      M,      M,      IB,     IZ,     P,      X,      M,      M,      M,      M,      IB,     IZ,     P,      X,
+			/* 3 */   M,      M,      M,      M,      IB,     IZ,     P,      X,      M,      M,      M,      M,      IB,     IZ,     P,      X,
+			/* 4 */   0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+			/* 5 */   0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+			/* 6 */   X,      X,      0,      M,      P,      P,      P,      P,      IZ,     M|IZ,   IB,     M|IB,   0,      0,      0,      0,
+			/* 7 */   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,   REL8,
+			/* 8 */   M|IB,   M|IZ,   X,      M|IB,   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 9 */   0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      X,      0,      0,      0,      0,      0,
+			/* A */   MOFFS,  MOFFS,  MOFFS,  MOFFS,  0,      0,      0,      0,      IB,     IZ,     0,      0,      0,      0,      0,      0,
+			/* B */   IB,     IB,     IB,     IB,     IB,     IB,     IB,     IB,     IV,     IV,     IV,     IV,     IV,     IV,     IV,     IV,
+			/* C */   M|IB,   M|IB,   IW,     0,      0,      0,      M|IB,   M|IZ,   IWB,    0,      IW,     0,      0,      IB,     X,      0,
+			/* D */   M,      M,      M,      M,      X,      X,      X,      0,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* E */   REL8,   REL8,   REL8,   REL8,   IB,     IB,     IB,     IB,     REL32,  REL32,  X,      REL8,   0,      0,      0,      0,
+			/* F */   P,      0,      P,      P,      0,      0,      M|GRP3B,M|GRP3Z,0,      0,      0,      0,      0,      0,      M,      M,
+		};
+
+		/* Two-byte opcode map (0F xx). 0F 38 and 0F 3A are handled by the decoder. */
+		constexpr uint8_t TwoByte[256] =
+		{
+			/*        0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F */
+			/* 0 */   M,      M,      M,      M,      X,      0,      0,      0,      0,      0,      X,      0,      X,      M,      0,      M|IB,
+			/* 1 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 2 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 3 */   0,      0,      0,      0,      0,      0,      X,      0,      0,      X,      0,      X,      X,      X,      X,      X,
+			/* 4 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 5 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 6 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* 7 */   M|IB,   M|IB,   M|IB,   M|IB,   M,      M,      M,      0,      M,      M,      X,      X,      M,      M,      M,      M,
+			/* 8 */   REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,  REL32,
+			/* 9 */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* A */   0,      0,      0,      M,      M|IB,   M,      X,      X,      0,      0,      0,      M,      M|IB,   M,      M,      M,
+			/* B */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M|IB,   M,      M,      M,      M,      M,
+			/* C */   M,      M,      M|IB,   M,      M|IB,   M|IB,   M|IB,   M,      0,      0,      0,      0,      0,      0,      0,      0,
+			/* D */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* E */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+			/* F */   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+		};
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// DecodeInstruction:
+	/// 	Decodes the length and layout of the x86-64 instruction at aCode, reading at most
+	/// 	aAvailable bytes. Returns false if the bytes are not a valid instruction.
+	///----------------------------------------------------------------------------------------------------
+	inline bool DecodeInstruction(const uint8_t* aCode, uint64_t aAvailable, DecodedInstruction& aOut)
+	{
+		using namespace decoder;
+
+		aOut = DecodedInstruction{};
+
+		uint64_t limit = std::min<uint64_t>(aAvailable, 15); /* architectural maximum */
+		uint64_t pos   = 0;
+
+		bool    operandSize16 = false;
+		bool    addressSize32 = false;
+		uint8_t rex           = 0;
+
+		/* Legacy prefixes and REX. REX only counts directly before the opcode. */
+		while (true)
+		{
+			if (pos >= limit) { return false; }
+
+			uint8_t b = aCode[pos];
+
+			if ((b & 0xF0) == 0x40)
+			{
+				rex = b;
+				pos++;
+				continue;
+			}
+
+			if (!(OneByte[b] & P)) { break; }
+
+			if (b == 0x66) { operandSize16 = true; }
+			if (b == 0x67) { addressSize32 = true; }
+
+			rex = 0;
+			pos++;
+		}
+
+		bool    rexW  = (rex & 0x08) != 0;
+		uint8_t entry = 0;
+		uint8_t b     = aCode[pos];
+
+		if (b == 0xC4 || b == 0xC5 || b == 0x62)
+		{
+			/* VEX / EVEX: ModRM always follows the opcode, the map selects the immediate. */
+			uint64_t payload = b == 0xC5 ? 1 : (b == 0xC4 ? 2 : 3);
+			if (pos + 1 + payload >= limit) { return false; }
+
+			uint8_t map = b == 0xC5 ? 1 : (aCode[pos + 1] & (b == 0xC4 ? 0x1F : 0x07));
+			pos += 1 + payload;
+
+			aOut.OpcodeOffset = (uint8_t)pos;
+			uint8_t opcode = aCode[pos++];
+
+			if (map == 1)
+			{
+				/* Only the imm8 forms of the two-byte map carry over, e.g. vpshufd or vcmpps. */
+				entry = opcode == 0x77 ? 0 : (uint8_t)(M | ((TwoByte[opcode] & 0xF0) == IB ? IB : 0));
+			}
+			else if (map == 2)
+			{
+				entry = M;
+			}
+			else if (map == 3)
+			{
+				entry = M | IB;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (b == 0x0F)
+		{
+			if (pos + 1 >= limit) { return false; }
+
+			uint8_t escape = aCode[pos + 1];
+
+			if (escape == 0x38 || escape == 0x3A)
+			{
+				pos += 2;
+				entry = escape == 0x38 ? M : (M | IB);
+			}
+			else
+			{
+				pos += 1;
+				entry = TwoByte[escape];
+			}
+
+			if (pos >= limit) { return false; }
+
+			aOut.OpcodeOffset = (uint8_t)pos;
+			pos++;
+		}
+		else
+		{
+			entry = OneByte[b];
+			aOut.OpcodeOffset = (uint8_t)pos;
+			pos++;
+		}
+
+		if (entry & X) { return false; }
+
+		uint8_t immKind = entry & 0xF0;
+
+		if (entry & M)
+		{
+			if (pos >= limit) { return false; }
+
+			uint8_t modrm = aCode[pos];
+			uint8_t mod   = modrm >> 6;
+			uint8_t reg   = (modrm >> 3) & 7;
+			uint8_t rm    = modrm & 7;
+
+			aOut.HasModRM    = true;
+			aOut.ModRMOffset = (uint8_t)pos;
+			pos++;
+
+			if (mod != 3)
+			{
+				if (rm == 4)
+				{
+					/* SIB, base 101 without displacement means disp32 without base. */
+					if (pos >= limit) { return false; }
+					if (mod == 0 && (aCode[pos] & 7) == 5) { aOut.DispSize = 4; }
+					pos++;
+				}
+				else if (mod == 0 && rm == 5)
+				{
+					aOut.DispSize      = 4;
+					aOut.IsRipRelative = true;
+				}
+
+				if (mod == 1) { aOut.DispSize = 1; }
+				if (mod == 2) { aOut.DispSize = 4; }
+			}
+
+			if (aOut.DispSize)
+			{
+				aOut.DispOffset = (uint8_t)pos;
+				pos += aOut.DispSize;
+			}
+
+			if (immKind == GRP3B) { immKind = reg < 2 ? IB : 0; }
+			if (immKind == GRP3Z) { immKind = reg < 2 ? IZ : 0; }
+		}
+
+		uint8_t immSize = 0;
+
+		switch (immKind)
+		{
+			case IB:    immSize = 1; break;
+			case IW:    immSize = 2; break;
+			case IZ:    immSize = operandSize16 && !rexW ? 2 : 4; break;
+			case IV:    immSize = rexW ? 8 : (operandSize16 ? 2 : 4); break;
+			case IWB:   immSize = 3; break;
+			case MOFFS: immSize = addressSize32 ? 4 : 8; break;
+			case REL8:  immSize = 1; aOut.IsBranch = true; break;
+			case REL32: immSize = 4; aOut.IsBranch = true; break;
+			default:    break;
+		}
+
+		if (immSize)
+		{
+			aOut.ImmOffset = (uint8_t)pos;
+			aOut.ImmSize   = immSize;
+			pos += immSize;
+		}
+
+		if (pos > limit) { return false; }
+
+		aOut.Length = (uint8_t)pos;
+
+		return true;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// GetRelativeTarget:
+	/// 	Returns the address a decoded branch or RIP-relative operand refers to, or nullptr.
+	///----------------------------------------------------------------------------------------------------
+	inline void* GetRelativeTarget(PBYTE aInstruction, const DecodedInstruction& aDecoded)
+	{
+		PBYTE next = aInstruction + aDecoded.Length;
+
+		if (aDecoded.IsBranch && aDecoded.ImmSize == 1)
+		{
+			return next + *(__unaligned int8_t*)&aInstruction[aDecoded.ImmOffset];
+		}
+
+		if (aDecoded.IsBranch && aDecoded.ImmSize == 4)
+		{
+			return next + *(__unaligned int32_t*)&aInstruction[aDecoded.ImmOffset];
+		}
+
+		if (aDecoded.IsRipRelative)
+		{
+			return next + *(__unaligned int32_t*)&aInstruction[aDecoded.DispOffset];
+		}
+
+		return nullptr;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// InstructionMap Struct
+	/// 	Bitmap of instruction starts in a code range, used to reject matches inside instructions.
+	///----------------------------------------------------------------------------------------------------
+	struct InstructionMap
+	{
+		PBYTE                 Base = nullptr;
+		uint64_t              Size = 0;
+		std::vector<uint64_t> Starts;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Decodes linearly from the start of the range. Undecodable bytes are skipped one at a time.
+		///----------------------------------------------------------------------------------------------------
+		inline InstructionMap(PBYTE aBase, uint64_t aSize)
+			: InstructionMap(aBase, aSize, std::vector<PBYTE>{ aBase })
+		{
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Decodes forward from each known function entry up to the next entry.
+		///----------------------------------------------------------------------------------------------------
+		inline InstructionMap(PBYTE aBase, uint64_t aSize, std::vector<PBYTE> aEntries)
+			: Base(aBase)
+			, Size(aSize)
+			, Starts((aSize + 63) / 64, 0)
+		{
+			std::sort(aEntries.begin(), aEntries.end());
+
+			for (size_t i = 0; i < aEntries.size(); i++)
+			{
+				if (aEntries[i] < aBase || aEntries[i] >= aBase + aSize) { continue; }
+
+				uint64_t pos = (uint64_t)(aEntries[i] - aBase);
+				uint64_t end = i + 1 < aEntries.size() && aEntries[i + 1] < aBase + aSize ? (uint64_t)(aEntries[i + 1] - aBase) : aSize;
+
+				while (pos < end)
+				{
+					DecodedInstruction decoded;
+
+					if (!DecodeInstruction(&aBase[pos], end - pos, decoded))
+					{
+						pos++;
+						continue;
+					}
+
+					this->Starts[pos / 64] |= 1ULL << (pos % 64);
+					pos += decoded.Length;
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsStart:
+		/// 	Returns true if an instruction starts at the address.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsStart(const void* aAddress) const
+		{
+			if ((PBYTE)aAddress < this->Base || (PBYTE)aAddress >= this->Base + this->Size) { return false; }
+
+			uint64_t pos = (uint64_t)((PBYTE)aAddress - this->Base);
+
+			return (this->Starts[pos / 64] >> (pos % 64)) & 1;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// unwind Namespace
+	/// 	Readers for the DWARF encoded values of .eh_frame and .eh_frame_hdr.
+	///----------------------------------------------------------------------------------------------------
+	namespace unwind
+	{
+		static constexpr uint8_t DW_EH_PE_omit    = 0xFF;
+		static constexpr uint8_t DW_EH_PE_pcrel   = 0x10;
+		static constexpr uint8_t DW_EH_PE_datarel = 0x30;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ReadULEB128 / ReadSLEB128:
+		/// 	Reads a LEB128 value at aData. Returns false if it runs past aEnd.
+		///----------------------------------------------------------------------------------------------------
+		inline bool ReadULEB128(const uint8_t*& aData, const uint8_t* aEnd, uint64_t& aValue)
+		{
+			uint32_t shift = 0;
+			uint8_t  byte  = 0;
+
+			aValue = 0;
+
+			do
+			{
+				if (aData >= aEnd) { return false; }
+
+				byte = *aData++;
+
+				if (shift < 64) { aValue |= (uint64_t)(byte & 0x7F) << shift; }
+
+				shift += 7;
+			}
+			while (byte & 0x80);
+
+			return true;
+		}
+
+		inline bool ReadSLEB128(const uint8_t*& aData, const uint8_t* aEnd, int64_t& aValue)
+		{
+			uint64_t value = 0;
+			uint32_t shift = 0;
+			uint8_t  byte  = 0;
+
+			do
+			{
+				if (aData >= aEnd) { return false; }
+
+				byte = *aData++;
+
+				if (shift < 64) { value |= (uint64_t)(byte & 0x7F) << shift; }
+
+				shift += 7;
+			}
+			while (byte & 0x80);
+
+			/* Sign extend. */
+			if (shift < 64 && (byte & 0x40)) { value |= ~0ULL << shift; }
+
+			aValue = (int64_t)value;
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ReadEncoded:
+		/// 	Reads a pointer of the given DW_EH_PE encoding at aData, which lies at aAddress in the
+		/// 	image. aDataBase is the base of datarel values. Returns false for unsupported encodings
+		/// 	and values running past aEnd.
+		///----------------------------------------------------------------------------------------------------
+		inline bool ReadEncoded(const uint8_t*& aData, const uint8_t* aEnd, uint64_t aAddress, uint8_t aEncoding, uint64_t aDataBase, uint64_t& aValue)
+		{
+			bool fits = true;
+
+			auto read = [&](auto aType)
+			{
+				decltype(aType) v = 0;
+
+				if ((uint64_t)(aEnd - aData) < sizeof(v)) { fits = false; return v; }
+
+				memcpy(&v, aData, sizeof(v));
+				aData += sizeof(v);
+				return v;
+			};
+
+			if (aData > aEnd) { return false; }
+
+			switch (aEncoding & 0x0F)
+			{
+				case 0x00: aValue = read(uint64_t()); break;                                           /* absptr */
+				case 0x01: fits = ReadULEB128(aData, aEnd, aValue); break;                             /* uleb128 */
+				case 0x02: aValue = read(uint16_t()); break;                                           /* udata2 */
+				case 0x03: aValue = read(uint32_t()); break;                                           /* udata4 */
+				case 0x04: aValue = read(uint64_t()); break;                                           /* udata8 */
+				case 0x09: fits = ReadSLEB128(aData, aEnd, reinterpret_cast<int64_t&>(aValue)); break; /* sleb128 */
+				case 0x0A: aValue = (uint64_t)(int64_t)read(int16_t()); break;                         /* sdata2 */
+				case 0x0B: aValue = (uint64_t)(int64_t)read(int32_t()); break;                         /* sdata4 */
+				case 0x0C: aValue = (uint64_t)read(int64_t()); break;                                  /* sdata8 */
+				default:   return false;
+			}
+
+			if (!fits) { return false; }
+
+			switch (aEncoding & 0x70)
+			{
+				case 0x00:             break;
+				case DW_EH_PE_pcrel:   aValue += aAddress; break;
+				case DW_EH_PE_datarel: aValue += aDataBase; break;
+				default:               return false;
+			}
+
+			return true;
+		}
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// RegionMap Struct
+	/// 	Cached map of the executable regions of the process, so repeated scans skip the per-region
+	/// 	queries. Module loads and unloads update it incrementally, from LdrRegisterDllNotification
+	/// 	on Windows and from the load / unload counters of dl_iterate_phdr on Linux.
+	/// 	Executable memory outside of modules (e.g. JIT code) is only picked up by Refresh.
+	/// 	The generation increases with every change.
+	///----------------------------------------------------------------------------------------------------
+	struct RegionMap
+	{
+		struct Region
+		{
+			PBYTE    Base;
+			uint64_t Size;
+			PBYTE    Module; /* nullptr if not part of a module */
+		};
+
+		///----------------------------------------------------------------------------------------------------
+		/// Get:
+		/// 	Returns the process wide region map. The first call performs a full refresh.
+		///----------------------------------------------------------------------------------------------------
+		static inline RegionMap& Get()
+		{
+			static RegionMap s_Instance;
+			return s_Instance;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetGeneration:
+		/// 	Returns a counter that changes whenever the map changes.
+		///----------------------------------------------------------------------------------------------------
+		inline uint64_t GetGeneration()
+		{
+			this->Sync();
+			return this->Generation.load(std::memory_order_acquire);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetRegions:
+		/// 	Returns a snapshot of the regions, sorted by address.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<Region> GetRegions()
+		{
+			this->Sync();
+
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+			return this->Regions;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Refresh:
+		/// 	Re-enumerates all executable regions of the process.
+		///----------------------------------------------------------------------------------------------------
+		inline void Refresh()
+		{
+			std::vector<Region> regions;
+
+			ForEachRegion(nullptr, [&regions](PBYTE aBase, uint64_t aSize)
+			{
+				regions.push_back(Region{ aBase, aSize, GetModuleBaseFromAddress(aBase) });
+				return true;
+			});
+
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+
+			this->Regions = std::move(regions);
+#ifndef _WIN32
+			this->ReadLoadCounters(this->Loads, this->Unloads);
+			this->Modules = EnumerateModules();
+#endif
+			this->Generation.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// AddModule:
+		/// 	Adds the executable regions of a loaded module and notifies the listeners.
+		///----------------------------------------------------------------------------------------------------
+		inline void AddModule(PBYTE aModule, uint64_t aImageSize = 0)
+		{
+			std::vector<Region> regions;
+
+#ifdef _WIN32
+			if (!aImageSize)
+			{
+				MODULEINFO info{};
+				if (!GetModuleInformation(GetCurrentProcess(), (HMODULE)aModule, &info, sizeof(info))) { return; }
+				aImageSize = info.SizeOfImage;
+			}
+
+			ForEachRegion(aModule, [&regions, aModule](PBYTE aBase, uint64_t aSize)
+			{
+				regions.push_back(Region{ aBase, aSize, aModule });
+				return true;
+			}, aModule + aImageSize);
+#else
+			(void)aImageSize;
+
+			regions = ModuleRegions(aModule);
+#endif
+
+			{
+				const std::lock_guard<std::mutex> lock(this->Mutex);
+
+				for (const Region& region : regions)
+				{
+					auto it = std::lower_bound(this->Regions.begin(), this->Regions.end(), region.Base, [](const Region& aRegion, PBYTE aBase)
+					{
+						return aRegion.Base < aBase;
+					});
+
+					/* Already known, e.g. from a refresh. */
+					if (it != this->Regions.end() && it->Base == region.Base) { continue; }
+
+					this->Regions.insert(it, region);
+				}
+
+				this->Generation.fetch_add(1, std::memory_order_acq_rel);
+			}
+
+			this->Notify(aModule);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// RemoveModule:
+		/// 	Removes the regions of an unloaded module.
+		///----------------------------------------------------------------------------------------------------
+		inline void RemoveModule(PBYTE aModule)
+		{
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+
+			this->Regions.erase(std::remove_if(this->Regions.begin(), this->Regions.end(), [aModule](const Region& aRegion)
+			{
+				return aRegion.Module == aModule;
+			}), this->Regions.end());
+
+			this->Generation.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// OnModuleLoaded:
+		/// 	Registers a callback invoked with the base of every newly loaded module, e.g. to resolve
+		/// 	its signatures with PatternScan::ScanModule. On Windows it runs under the loader lock.
+		///----------------------------------------------------------------------------------------------------
+		inline void OnModuleLoaded(std::function<void(PBYTE)> aCallback)
+		{
+			const std::lock_guard<std::mutex> lock(this->ListenerMutex);
+			this->Listeners.push_back(std::move(aCallback));
+		}
+
+	private:
+		std::mutex                              Mutex;
+		std::vector<Region>                     Regions;
+		std::atomic<uint64_t>                   Generation{ 0 };
+		std::mutex                              ListenerMutex;
+		std::vector<std::function<void(PBYTE)>> Listeners;
+
+		inline RegionMap()
+		{
+			this->Refresh();
+#ifdef _WIN32
+			this->RegisterNotification();
+#endif
+		}
+
+		inline ~RegionMap()
+		{
+#ifdef _WIN32
+			this->UnregisterNotification();
+#endif
+		}
+
+		RegionMap(const RegionMap&) = delete;
+		RegionMap& operator=(const RegionMap&) = delete;
+
+		inline void Notify(PBYTE aModule)
+		{
+			std::vector<std::function<void(PBYTE)>> listeners;
+
+			{
+				const std::lock_guard<std::mutex> lock(this->ListenerMutex);
+				listeners = this->Listeners;
+			}
+
+			for (const auto& listener : listeners) { listener(aModule); }
+		}
+
+#ifdef _WIN32
+		struct DllNotificationData
+		{
+			ULONG       Flags;
+			const void* FullDllName;
+			const void* BaseDllName;
+			PVOID       DllBase;
+			ULONG       SizeOfImage;
+		};
+
+		typedef VOID(CALLBACK* DllNotificationFunction)(ULONG aReason, const DllNotificationData* aData, PVOID aContext);
+		typedef LONG(NTAPI* LdrRegisterDllNotificationFunction)(ULONG aFlags, DllNotificationFunction aCallback, PVOID aContext, PVOID* aCookie);
+		typedef LONG(NTAPI* LdrUnregisterDllNotificationFunction)(PVOID aCookie);
+
+		PVOID Cookie = nullptr;
+
+		inline void RegisterNotification()
+		{
+			auto registerNotification = (LdrRegisterDllNotificationFunction)(void*)GetProcAddress(GetModuleHandleA("ntdll.dll"), "LdrRegisterDllNotification");
+
+			if (!registerNotification) { return; }
+
+			registerNotification(0, [](ULONG aReason, const DllNotificationData* aData, PVOID aContext)
+			{
+				RegionMap* map = (RegionMap*)aContext;
+
+				if (aReason == 1 /* LDR_DLL_NOTIFICATION_REASON_LOADED */)
+				{
+					map->AddModule((PBYTE)aData->DllBase, aData->SizeOfImage);
+				}
+				else if (aReason == 2 /* LDR_DLL_NOTIFICATION_REASON_UNLOADED */)
+				{
+					map->RemoveModule((PBYTE)aData->DllBase);
+				}
+			}, this, &this->Cookie);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// UnregisterNotification:
+		/// 	Stops the loader from calling into the map once it is destroyed, e.g. when a DLL using it
+		/// 	is unloaded while the process keeps running.
+		///----------------------------------------------------------------------------------------------------
+		inline void UnregisterNotification()
+		{
+			auto unregisterNotification = (LdrUnregisterDllNotificationFunction)(void*)GetProcAddress(GetModuleHandleA("ntdll.dll"), "LdrUnregisterDllNotification");
+
+			if (this->Cookie && unregisterNotification) { unregisterNotification(this->Cookie); }
+
+			this->Cookie = nullptr;
+		}
+
+		inline void Sync()
+		{
+			/* Kept current by the loader notification. */
+		}
+#else
+		struct Module
+		{
+			PBYTE    Base;
+			uint64_t Identity; /* hash of the path and the PT_LOAD headers */
+		};
+
+		unsigned long long  Loads   = 0;
+		unsigned long long  Unloads = 0;
+		std::vector<Module> Modules;
+
+		static inline void ReadLoadCounters(unsigned long long& aLoads, unsigned long long& aUnloads)
+		{
+			struct Counters
+			{
+				unsigned long long Loads;
+				unsigned long long Unloads;
+			} counters{ 0, 0 };
+
+			dl_iterate_phdr([](dl_phdr_info* aInfo, size_t aSize, void* aData) -> int
+			{
+				if (aSize >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(aInfo->dlpi_subs))
+				{
+					((Counters*)aData)->Loads   = aInfo->dlpi_adds;
+					((Counters*)aData)->Unloads = aInfo->dlpi_subs;
+				}
+
+				/* The counters are the same for every entry. */
+				return 1;
+			}, &counters);
+
+			aLoads   = counters.Loads;
+			aUnloads = counters.Unloads;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// EnumerateModules:
+		/// 	Returns the loaded modules sorted by base. A different module loaded at the base of an
+		/// 	unloaded one has a different identity.
+		///----------------------------------------------------------------------------------------------------
+		static inline std::vector<Module> EnumerateModules()
+		{
+			std::vector<Module> modules;
+
+			dl_iterate_phdr([](dl_phdr_info* aInfo, size_t, void* aData) -> int
+			{
+				PBYTE    base     = nullptr;
+				uint64_t identity = HashBytes(aInfo->dlpi_name, aInfo->dlpi_name ? strlen(aInfo->dlpi_name) : 0);
+
+				for (ElfW(Half) i = 0; i < aInfo->dlpi_phnum; i++)
+				{
+					const ElfW(Phdr)& header = aInfo->dlpi_phdr[i];
+
+					if (header.p_type != PT_LOAD) { continue; }
+
+					if (!base && header.p_offset == 0)
+					{
+						base = (PBYTE)(aInfo->dlpi_addr + header.p_vaddr);
+					}
+
+					uint64_t layout[] = { header.p_vaddr, header.p_memsz, header.p_flags };
+					identity = HashBytes(layout, sizeof(layout), identity);
+				}
+
+				if (base) { ((std::vector<Module>*)aData)->push_back(Module{ base, identity }); }
+
+				return 0;
+			}, &modules);
+
+			std::sort(modules.begin(), modules.end(), ByModule);
+
+			return modules;
+		}
+
+		static inline bool ByModule(const Module& aLhs, const Module& aRhs)
+		{
+			return aLhs.Base != aRhs.Base ? aLhs.Base < aRhs.Base : aLhs.Identity < aRhs.Identity;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ModuleRegions:
+		/// 	Returns the executable segments of a loaded module.
+		///----------------------------------------------------------------------------------------------------
+		static inline std::vector<Region> ModuleRegions(PBYTE aModule)
+		{
+			std::vector<Region> regions;
+
+			for (const Range& section : GetExecutableSections(aModule))
+			{
+				/* Segments are mapped page granular. */
+				uintptr_t start = (uintptr_t)(aModule + section.Offset) & ~(uintptr_t)0xFFF;
+				uintptr_t end   = ((uintptr_t)(aModule + section.Offset + section.Size) + 0xFFF) & ~(uintptr_t)0xFFF;
+
+				regions.push_back(Region{ (PBYTE)start, (uint64_t)(end - start), aModule });
+			}
+
+			return regions;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Sync:
+		/// 	Applies module loads and unloads since the last sync. Checking the counters costs one
+		/// 	dl_iterate_phdr step, the module list is only diffed when they changed.
+		/// 	After unloads the regions of all modules are rebuilt, as a module unloaded and another
+		/// 	loaded at the same base may leave the module list unchanged.
+		///----------------------------------------------------------------------------------------------------
+		inline void Sync()
+		{
+			unsigned long long loads   = 0;
+			unsigned long long unloads = 0;
+			ReadLoadCounters(loads, unloads);
+
+			std::vector<Module> modules;
+			std::vector<Module> added;
+			bool                hasUnloads = false;
+
+			{
+				const std::lock_guard<std::mutex> lock(this->Mutex);
+
+				if (loads == this->Loads && unloads == this->Unloads) { return; }
+
+				modules = EnumerateModules();
+
+				std::set_difference(modules.begin(), modules.end(), this->Modules.begin(), this->Modules.end(), std::back_inserter(added), ByModule);
+
+				hasUnloads    = unloads != this->Unloads;
+				this->Modules = modules;
+				this->Loads   = loads;
+				this->Unloads = unloads;
+			}
+
+			if (!hasUnloads)
+			{
+				for (const Module& module : added) { this->AddModule(module.Base); }
+				return;
+			}
+
+			std::vector<Region> regions;
+
+			for (const Module& module : modules)
+			{
+				std::vector<Region> moduleRegions = ModuleRegions(module.Base);
+				regions.insert(regions.end(), moduleRegions.begin(), moduleRegions.end());
+			}
+
+			{
+				const std::lock_guard<std::mutex> lock(this->Mutex);
+
+				/* Keep regions outside of modules, e.g. JIT code found by Refresh. */
+				for (const Region& region : this->Regions)
+				{
+					if (!region.Module) { regions.push_back(region); }
+				}
+
+				std::sort(regions.begin(), regions.end(), [](const Region& aLhs, const Region& aRhs) { return aLhs.Base < aRhs.Base; });
+
+				this->Regions = std::move(regions);
+				this->Generation.fetch_add(1, std::memory_order_acq_rel);
+			}
+
+			for (const Module& module : added) { this->Notify(module.Base); }
+		}
+#endif
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// FunctionBounds Struct
+	/// 	Start and end of a function in memory. Empty if no function was found.
+	///----------------------------------------------------------------------------------------------------
+	struct FunctionBounds
+	{
+		PBYTE Begin = nullptr;
+		PBYTE End   = nullptr;
+
+		inline bool Contains(const void* aAddress, uint64_t aSize = 1) const
+		{
+			return (PBYTE)aAddress >= this->Begin && (PBYTE)aAddress + aSize <= this->End;
+		}
+
+		inline explicit operator bool() const { return this->Begin != nullptr; }
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// FunctionTable Struct
+	/// 	Sorted function ranges of a PE or ELF64 image, built from its unwind data: the
+	/// 	RUNTIME_FUNCTION entries of .pdata, or the FDEs listed in .eh_frame_hdr.
+	/// 	Ranges are relative to the loaded module base, also when built from a file.
+	/// 	Functions without unwind data, e.g. leaf functions in PE images, are not listed.
+	///----------------------------------------------------------------------------------------------------
+	struct FunctionTable
+	{
+		struct Entry
+		{
+			uint64_t Begin;
+			uint64_t End;
+		};
+
+		PBYTE              Base = nullptr; /* the module, if built from a loaded one */
+		std::vector<Entry> Functions;
+
+		FunctionTable() = default;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		/// 	Set aIsMapped to false if the image is a file read from disk instead of a loaded module, and
+		/// 	pass the file size as aSize. The table is empty if the unwind data is malformed.
+		///----------------------------------------------------------------------------------------------------
+		inline explicit FunctionTable(const void* aImage, bool aIsMapped = true, uint64_t aSize = UINT64_MAX)
+			: Base(aIsMapped ? (PBYTE)aImage : nullptr)
+		{
+			const uint8_t* image = (const uint8_t*)aImage;
+
+			if (!image || aSize < 0x40) { return; }
+
+			bool parsed = false;
+
+			if (image[0] == 'M' && image[1] == 'Z')
+			{
+				parsed = this->ParsePdata(image, aIsMapped, aSize);
+			}
+			else if (image[0] == 0x7F && image[1] == 'E' && image[2] == 'L' && image[3] == 'F' && image[4] == 2 /* ELFCLASS64 */)
+			{
+				parsed = this->ParseEhFrameHdr(image, aIsMapped, aSize);
+			}
+
+			if (!parsed)
+			{
+				this->Functions.clear();
+				return;
+			}
+
+			std::sort(this->Functions.begin(), this->Functions.end(), [](const Entry& aLeft, const Entry& aRight) { return aLeft.Begin < aRight.Begin; });
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ForModule:
+		/// 	Returns the table of a loaded module, built on first use and rebuilt if the module changed.
+		/// 	The module is only fingerprinted again once the RegionMap saw modules load or unload.
+		///----------------------------------------------------------------------------------------------------
+		static inline std::shared_ptr<const FunctionTable> ForModule(PBYTE aModule)
+		{
+			struct Cached
+			{
+				uint64_t                             Generation  = 0;
+				uint64_t                             Fingerprint = 0;
+				std::shared_ptr<const FunctionTable> Table;
+			};
+
+			static std::mutex                        s_Mutex;
+			static std::unordered_map<PBYTE, Cached> s_Tables;
+
+			if (!aModule) { return nullptr; }
+
+			uint64_t generation = RegionMap::Get().GetGeneration();
+
+			const std::lock_guard<std::mutex> lock(s_Mutex);
+
+			Cached& cached = s_Tables[aModule];
+
+			if (cached.Table && cached.Generation == generation) { return cached.Table; }
+
+			uint64_t fingerprint = FingerprintModule(aModule, GetExecutableSections(aModule));
+
+			if (!cached.Table || cached.Fingerprint != fingerprint)
+			{
+				cached.Fingerprint = fingerprint;
+				cached.Table       = std::make_shared<const FunctionTable>(aModule);
+			}
+
+			cached.Generation = generation;
+
+			return cached.Table;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Find:
+		/// 	Returns the function containing the module offset, or nullptr. O(log n).
+		///----------------------------------------------------------------------------------------------------
+		inline const Entry* Find(uint64_t aOffset) const
+		{
+			auto it = std::upper_bound(this->Functions.begin(), this->Functions.end(), aOffset, [](uint64_t aValue, const Entry& aEntry) { return aValue < aEntry.Begin; });
+
+			if (it == this->Functions.begin()) { return nullptr; }
+
+			it--;
+
+			return aOffset < it->End ? &*it : nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Find:
+		/// 	Returns the bounds of the function containing aAddress, for tables of loaded modules.
+		///----------------------------------------------------------------------------------------------------
+		inline FunctionBounds Find(const void* aAddress) const
+		{
+			if (!this->Base || (PBYTE)aAddress < this->Base) { return FunctionBounds(); }
+
+			const Entry* entry = this->Find((uint64_t)((PBYTE)aAddress - this->Base));
+
+			return entry ? FunctionBounds{ this->Base + entry->Begin, this->Base + entry->End } : FunctionBounds();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Crosses:
+		/// 	Returns true if the range does not lie within a single function, or a single gap between
+		/// 	functions. Used to reject pattern matches spanning two functions.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Crosses(uint64_t aOffset, uint64_t aSize) const
+		{
+			if (aSize == 0) { return false; }
+
+			/* Numbers the gaps and functions in address order: gap 0, function 0, gap 1, ... */
+			auto slot = [this](uint64_t aPosition)
+			{
+				auto it = std::upper_bound(this->Functions.begin(), this->Functions.end(), aPosition, [](uint64_t aValue, const Entry& aEntry) { return aValue < aEntry.Begin; });
+
+				uint64_t index = (uint64_t)(it - this->Functions.begin());
+
+				return index * 2 - (index && aPosition < this->Functions[index - 1].End ? 1 : 0);
+			};
+
+			return slot(aOffset) != slot(aOffset + aSize - 1);
+		}
+
+		inline bool IsValid() const { return !this->Functions.empty(); }
+
+	private:
+		static constexpr uint64_t MAX_FUNCTIONS = 16 * 1024 * 1024;
+
+		static inline bool Fits(uint64_t aSize, uint64_t aOffset, uint64_t aLength)
+		{
+			return aOffset <= aSize && aLength <= aSize - aOffset;
+		}
+
+		inline bool ParsePdata(const uint8_t* aImage, bool aIsMapped, uint64_t aSize)
+		{
+			auto read16 = [aImage](uint64_t aOffset) { uint16_t v; memcpy(&v, aImage + aOffset, sizeof(v)); return v; };
+			auto read32 = [aImage](uint64_t aOffset) { uint32_t v; memcpy(&v, aImage + aOffset, sizeof(v)); return v; };
+
+			uint32_t nt = read32(0x3C); /* e_lfanew */
+
+			if (!Fits(aSize, nt, 24 + 2) || read32(nt) != 0x00004550) { return false; } /* "PE\0\0" */
+
+			/* Only PE32+ images have .pdata. */
+			uint64_t optHeader = (uint64_t)nt + 24;
+
+			if (read16(optHeader) != 0x20B) { return true; }
+
+			if (!Fits(aSize, optHeader, 112 + 4 * 8)) { return false; }
+			if (read32(optHeader + 108) <= 3 /* NumberOfRvaAndSizes */) { return true; }
+
+			uint32_t directory     = read32(optHeader + 112 + 3 * 8); /* IMAGE_DIRECTORY_ENTRY_EXCEPTION */
+			uint32_t directorySize = read32(optHeader + 112 + 3 * 8 + 4);
+
+			if (!directory) { return true; }
+			if (directorySize / 12 > MAX_FUNCTIONS) { return false; }
+
+			uint64_t offset = directory;
+
+			if (!aIsMapped)
+			{
+				/* Translate the RVA to a file offset. */
+				uint16_t sectionCount = read16(nt + 6);
+				uint64_t sectionTable = optHeader + read16(nt + 20);
+
+				if (!Fits(aSize, sectionTable, (uint64_t)sectionCount * 40)) { return false; }
+
+				offset = 0;
+
+				for (uint16_t i = 0; i < sectionCount; i++)
+				{
+					uint64_t header         = sectionTable + i * 40;
+					uint32_t virtualAddress = read32(header + 12);
+					uint32_t size           = std::max(read32(header + 8), read32(header + 16));
+
+					if (directory >= virtualAddress && directory - virtualAddress < size)
+					{
+						offset = (uint64_t)read32(header + 20) + (directory - virtualAddress);
+						break;
+					}
+				}
+
+				if (!offset) { return false; }
+			}
+
+			if (!Fits(aSize, offset, directorySize / 12 * 12)) { return false; }
+
+			/* RUNTIME_FUNCTION { BeginAddress, EndAddress, UnwindInfoAddress } */
+			for (uint64_t i = 0; i < directorySize / 12; i++)
+			{
+				uint32_t begin = read32(offset + i * 12);
+				uint32_t end   = read32(offset + i * 12 + 4);
+
+				if (begin < end)
+				{
+					this->Functions.push_back(Entry{ begin, end });
+				}
+			}
+
+			return true;
+		}
+
+		inline bool ParseEhFrameHdr(const uint8_t* aImage, bool aIsMapped, uint64_t aSize)
+		{
+			auto read16 = [aImage](uint64_t aOffset) { uint16_t v; memcpy(&v, aImage + aOffset, sizeof(v)); return v; };
+			auto read32 = [aImage](uint64_t aOffset) { uint32_t v; memcpy(&v, aImage + aOffset, sizeof(v)); return v; };
+			auto read64 = [aImage](uint64_t aOffset) { uint64_t v; memcpy(&v, aImage + aOffset, sizeof(v)); return v; };
+
+			uint64_t phoff     = read64(0x20);
+			uint16_t phentsize = read16(0x36);
+			uint16_t phnum     = read16(0x38);
+
+			if (phentsize < 0x38 || !Fits(aSize, phoff, (uint64_t)phnum * phentsize)) { return false; }
+
+			uint64_t firstVaddr = UINT64_MAX;
+			uint64_t hdrVaddr   = 0;
+
+			for (uint16_t i = 0; i < phnum; i++)
+			{
+				uint64_t header = phoff + (uint64_t)i * phentsize;
+				uint32_t type   = read32(header);
+
+				if (type == 1 /* PT_LOAD */)
+				{
+					firstVaddr = std::min<uint64_t>(firstVaddr, read64(header + 0x10) & ~0xFFFULL);
+				}
+				else if (type == 0x6474E550 /* PT_GNU_EH_FRAME */)
+				{
+					hdrVaddr = read64(header + 0x10);
+				}
+			}
+
+			if (!hdrVaddr || firstVaddr == UINT64_MAX) { return true; }
+
+			/* Returns the image data at a virtual address and the end of its segment's data in aEnd,
+			   nullptr if the image doesn't contain it. */
+			auto at = [&](uint64_t aVaddr, const uint8_t*& aEnd) -> const uint8_t*
+			{
+				for (uint16_t i = 0; i < phnum; i++)
+				{
+					uint64_t header = phoff + (uint64_t)i * phentsize;
+					uint64_t vaddr  = read64(header + 0x10);
+					uint64_t filesz = read64(header + 0x20);
+
+					if (read32(header) != 1 || aVaddr < vaddr || aVaddr - vaddr >= filesz) { continue; }
+
+					uint64_t start = aIsMapped ? vaddr - firstVaddr : read64(header + 0x08);
+
+					if (start >= aSize) { return nullptr; }
+
+					uint64_t available = std::min(filesz, aSize - start);
+
+					if (aVaddr - vaddr >= available) { return nullptr; }
+
+					aEnd = aImage + start + available;
+
+					return aImage + start + (aVaddr - vaddr);
+				}
+
+				return nullptr;
+			};
+
+			const uint8_t* hdrEnd = nullptr;
+			const uint8_t* hdr    = at(hdrVaddr, hdrEnd);
+
+			/* version, eh_frame_ptr_enc, fde_count_enc, table_enc */
+			if (!hdr || hdrEnd - hdr < 4 || hdr[0] != 1) { return false; }
+			if (hdr[2] == unwind::DW_EH_PE_omit || hdr[3] == unwind::DW_EH_PE_omit) { return true; }
+
+			const uint8_t* data    = hdr + 4;
+			uint64_t       ehFrame = 0;
+			uint64_t       count   = 0;
+
+			if (!unwind::ReadEncoded(data, hdrEnd, hdrVaddr + (data - hdr), hdr[1], hdrVaddr, ehFrame)) { return false; }
+			if (!unwind::ReadEncoded(data, hdrEnd, hdrVaddr + (data - hdr), hdr[2], hdrVaddr, count) || count > MAX_FUNCTIONS) { return false; }
+
+			std::unordered_map<uint64_t, uint8_t> cieEncodings;
+
+			for (uint64_t i = 0; i < count; i++)
+			{
+				uint64_t start = 0;
+				uint64_t fde   = 0;
+
+				if (!unwind::ReadEncoded(data, hdrEnd, hdrVaddr + (data - hdr), hdr[3], hdrVaddr, start)) { return false; }
+				if (!unwind::ReadEncoded(data, hdrEnd, hdrVaddr + (data - hdr), hdr[3], hdrVaddr, fde)) { return false; }
+
+				uint64_t size = 0;
+
+				if (!this->ReadFdeRange(at, fde, cieEncodings, size)) { return false; }
+
+				if (size > 0 && start >= firstVaddr)
+				{
+					this->Functions.push_back(Entry{ start - firstVaddr, start - firstVaddr + size });
+				}
+			}
+
+			return true;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ReadRecord:
+		/// 	Returns the CIE or FDE at aAddress, with the size of its length fields in aHeader and its
+		/// 	end in aEnd. Returns nullptr if the record doesn't fit in its segment.
+		///----------------------------------------------------------------------------------------------------
+		template <typename At>
+		static inline const uint8_t* ReadRecord(const At& aAt, uint64_t aAddress, uint64_t& aHeader, const uint8_t*& aEnd)
+		{
+			const uint8_t* segmentEnd = nullptr;
+			const uint8_t* record     = aAt(aAddress, segmentEnd);
+
+			if (!record || segmentEnd - record < 4) { return nullptr; }
+
+			uint32_t length32;
+			memcpy(&length32, record, sizeof(length32));
+
+			uint64_t length = length32;
+
+			aHeader = 4;
+
+			/* 64-bit DWARF has an extended length. */
+			if (length32 == 0xFFFFFFFF)
+			{
+				if (segmentEnd - record < 12) { return nullptr; }
+
+				memcpy(&length, record + 4, sizeof(length));
+				aHeader = 12;
+			}
+
+			uint64_t idSize = aHeader == 12 ? 8 : 4;
+
+			if (length < idSize || length > (uint64_t)(segmentEnd - record) - aHeader) { return nullptr; }
+
+			aEnd = record + aHeader + length;
+
+			return record;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ReadFdeRange:
+		/// 	Reads the pc_range of the FDE at aFde, with the pointer encoding of its CIE.
+		///----------------------------------------------------------------------------------------------------
+		template <typename At>
+		inline bool ReadFdeRange(const At& aAt, uint64_t aFde, std::unordered_map<uint64_t, uint8_t>& aCieEncodings, uint64_t& aSize) const
+		{
+			uint64_t       header = 0;
+			const uint8_t* end    = nullptr;
+			const uint8_t* fde    = ReadRecord(aAt, aFde, header, end);
+
+			if (!fde) { return false; }
+
+			uint64_t idSize    = header == 12 ? 8 : 4;
+			uint64_t cieOffset = 0;
+
+			memcpy(&cieOffset, fde + header, idSize);
+
+			/* The CIE pointer is relative to its own field, zero marks a CIE. */
+			if (cieOffset == 0 || cieOffset > aFde + header) { return false; }
+
+			uint64_t cie = aFde + header - cieOffset;
+			uint8_t  encoding;
+
+			if (auto it = aCieEncodings.find(cie); it != aCieEncodings.end())
+			{
+				encoding = it->second;
+			}
+			else
+			{
+				if (!ReadCieEncoding(aAt, cie, encoding)) { return false; }
+
+				aCieEncodings.emplace(cie, encoding);
+			}
+
+			const uint8_t* data  = fde + header + idSize;
+			uint64_t       begin = 0;
+
+			if (!unwind::ReadEncoded(data, end, aFde + (data - fde), encoding, 0, begin)) { return false; }
+
+			/* The range is a plain value of the same format. */
+			return unwind::ReadEncoded(data, end, aFde + (data - fde), encoding & 0x0F, 0, aSize);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ReadCieEncoding:
+		/// 	Reads the FDE pointer encoding from the 'R' augmentation of a CIE, absptr by default.
+		///----------------------------------------------------------------------------------------------------
+		template <typename At>
+		static inline bool ReadCieEncoding(const At& aAt, uint64_t aCie, uint8_t& aEncoding)
+		{
+			uint64_t       header = 0;
+			const uint8_t* end    = nullptr;
+			const uint8_t* cie    = ReadRecord(aAt, aCie, header, end);
+
+			if (!cie) { return false; }
+
+			uint64_t idSize = header == 12 ? 8 : 4;
+
+			const uint8_t* data = cie + header + idSize;
+
+			if (data >= end) { return false; }
+
+			uint8_t     version      = *data++;
+			const char* augmentation = (const char*)data;
+			const void* terminator   = memchr(data, 0, end - data);
+
+			if (!terminator) { return false; }
+
+			data = (const uint8_t*)terminator + 1;
+
+			if (strstr(augmentation, "eh"))
+			{
+				if ((uint64_t)(end - data) < sizeof(uint64_t)) { return false; }
+
+				data += sizeof(uint64_t);
+			}
+
+			uint64_t codeAlignment  = 0;
+			int64_t  dataAlignment  = 0;
+			uint64_t returnRegister = 0;
+
+			if (!unwind::ReadULEB128(data, end, codeAlignment)) { return false; }
+			if (!unwind::ReadSLEB128(data, end, dataAlignment)) { return false; }
+
+			if (version == 1)
+			{
+				if (data >= end) { return false; }
+
+				data++;
+			}
+			else if (!unwind::ReadULEB128(data, end, returnRegister))
+			{
+				return false;
+			}
+
+			aEncoding = 0;
+
+			if (augmentation[0] != 'z') { return true; }
+
+			uint64_t augmentationLength = 0;
+
+			if (!unwind::ReadULEB128(data, end, augmentationLength)) { return false; }
+
+			for (const char* c = augmentation + 1; *c; c++)
+			{
+				switch (*c)
+				{
+					case 'R':
+					{
+						if (data >= end) { return false; }
+
+						aEncoding = *data++;
+						return true;
+					}
+					case 'P':
+					{
+						if (data >= end) { return false; }
+
+						uint8_t  personalityEncoding = *data++;
+						uint64_t personality = 0;
+
+						if (!unwind::ReadEncoded(data, end, aCie + (data - cie), personalityEncoding & 0x7F, 0, personality)) { return false; }
+
+						break;
+					}
+					case 'L':
+					{
+						if (data >= end) { return false; }
+
+						data++;
+						break;
+					}
+					case 'S':
+					case 'B':
+						break;
+					default:
+						return true;
+				}
+			}
+
+			return true;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// FunctionContaining:
+	/// 	Returns the bounds of the function containing aAddress, from the unwind data of its module.
+	///----------------------------------------------------------------------------------------------------
+	inline FunctionBounds FunctionContaining(const void* aAddress)
+	{
+		std::shared_ptr<const FunctionTable> table = FunctionTable::ForModule(GetModuleBaseFromAddress(aAddress));
+
+		return table ? table->Find(aAddress) : FunctionBounds();
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// EOperation Enumeration
+	///----------------------------------------------------------------------------------------------------
+	enum class EOperation
+	{
+		NONE,
+		offset,
+		follow,
+		strcmp,
+		wcscmp,
+		cmpi8,
+		cmpi16,
+		cmpi32,
+		cmpi64,
+		pushaddr,
+		popaddr,
+		advwcard,
+		followinstr,
+		advinstr,
+		capaddr,
+		capi32,
+		capfollow
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Instruction Struct
+	///----------------------------------------------------------------------------------------------------
+	struct Instruction
+	{
+		EOperation     Operation;
+		int64_t        Value;
+		const char*    String;
+		const wchar_t* WString;
+
+		constexpr Instruction()                                      : Operation(EOperation::NONE), Value(0),      String(nullptr), WString(nullptr) {}
+		constexpr Instruction(EOperation aOp)                        : Operation(aOp),              Value(0),      String(nullptr), WString(nullptr) {}
+		constexpr Instruction(EOperation aOp, int64_t        aValue) : Operation(aOp),              Value(aValue), String(nullptr), WString(nullptr) {}
+		constexpr Instruction(EOperation aOp, const char*    aStr)   : Operation(aOp),              Value(0),      String(aStr),    WString(nullptr) {}
+		constexpr Instruction(EOperation aOp, const wchar_t* aWStr)  : Operation(aOp),              Value(0),      String(nullptr), WString(aWStr) {}
+
+		inline constexpr Instruction(const Instruction& aOther) 
+			: Operation(aOther.Operation)
+			, Value(aOther.Value)
+			, String(aOther.String)
+			, WString(aOther.WString)
+		{}
+
+		constexpr inline Instruction& operator=(const Instruction& aOther)
+		{
+			if (this == &aOther) { return *this; }
+
+			this->Operation = aOther.Operation;
+			this->Value = 0;
+			this->String = nullptr;
+			this->WString = nullptr;
+
+			switch (this->Operation)
+			{
+				case EOperation::strcmp:
+				{
+					this->String = aOther.String;
+					break;
+				}
+				case EOperation::wcscmp:
+				{
+					this->WString = aOther.WString;
+					break;
+				}
+				default:
+				{
+					this->Value = aOther.Value;
+					break;
+				}
+			}
+
+			return *this;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Offset:
+	/// 	Adds an offset (in bytes) to the current memory address.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction Offset(int64_t aValue) { return Instruction(EOperation::offset, aValue); }
+	
+	///----------------------------------------------------------------------------------------------------
+	/// Follow:
+	/// 	Interprets the current address as a relative address and follows it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction Follow() { return Instruction(EOperation::follow); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// Strcmp:
+	/// 	Interprets the current address as a relative address to a string, follows and compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction Strcmp(const char* aStr) { return Instruction(EOperation::strcmp, aStr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// Wcscmp:
+	/// 	Interprets the current address as a relative address to a wstring, follows and compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction Wcscmp(const wchar_t* aWStr) { return Instruction(EOperation::wcscmp, aWStr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CmpI8:
+	/// 	Interprets the current address as an i8 compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CmpI8(int64_t aValue) { return Instruction(EOperation::cmpi8, aValue); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CmpI16:
+	/// 	Interprets the current address as an i16 compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CmpI16(int64_t aValue) { return Instruction(EOperation::cmpi16, aValue); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CmpI32:
+	/// 	Interprets the current address as an i32 compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CmpI32(int64_t aValue) { return Instruction(EOperation::cmpi32, aValue); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CmpI64:
+	/// 	Interprets the current address as an i64 compares it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CmpI64(int64_t aValue) { return Instruction(EOperation::cmpi64, aValue); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// PushAddr:
+	/// 	Stores the current address on the address stack.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction PushAddr() { return Instruction(EOperation::pushaddr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// PopAddr:
+	/// 	Restores the last address on the address stack and removes it.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction PopAddr() { return Instruction(EOperation::popaddr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// AdvWcard:
+	/// 	Adds an offset to the current offset, so that the address will be at the next set of wildcards.
+	/// 	Pass aSets for how many amount of sets should be skipped.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction AdvWcard(int64_t aSets = 1) { return Instruction(EOperation::advwcard, aSets > 1 ? aSets : 1); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// FollowInstr:
+	/// 	Decodes the instruction at the current address and follows its branch or RIP-relative operand.
+	/// 	Fails if the instruction has no relative operand.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction FollowInstr() { return Instruction(EOperation::followinstr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// AdvInstr:
+	/// 	Decodes and skips aCount instructions. Fails on an invalid instruction.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction AdvInstr(int64_t aCount = 1) { return Instruction(EOperation::advinstr, aCount > 1 ? aCount : 1); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CaptureAddr:
+	/// 	Captures the current address into the ScanResult.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CaptureAddr() { return Instruction(EOperation::capaddr); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CaptureI32:
+	/// 	Captures the i32 at the current address, e.g. a struct field offset or an immediate.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CaptureI32() { return Instruction(EOperation::capi32); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// CaptureFollow:
+	/// 	Interprets the current address as a relative address and captures its target.
+	/// 	The current address stays the same.
+	///----------------------------------------------------------------------------------------------------
+	constexpr Instruction CaptureFollow() { return Instruction(EOperation::capfollow); }
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanResult Struct
+	/// 	Result address of a scan and the values captured on the way, in instruction order.
+	///----------------------------------------------------------------------------------------------------
+	struct ScanResult
+	{
+		void*                                        Address  = nullptr;
+		std::array<uint64_t, MAX_INSTRUCTION_LENGTH> Captures = {};
+		std::size_t                                  Count    = 0;
+
+		///----------------------------------------------------------------------------------------------------
+		/// Get:
+		/// 	Returns capture aIndex as a pointer or integer type.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T>
+		inline T Get(std::size_t aIndex) const
+		{
+			if (aIndex >= this->Count) { throw "Capture index out of range."; }
+
+			if constexpr (std::is_pointer_v<T>)
+			{
+				return (T)(uintptr_t)this->Captures[aIndex];
+			}
+			else
+			{
+				return (T)this->Captures[aIndex];
+			}
+		}
+
+		inline explicit operator bool() const { return this->Address != nullptr; }
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// EScanStatus Enumeration
+	///----------------------------------------------------------------------------------------------------
+	enum class EScanStatus
+	{
+		found,
+		notFound,
+		timedOut,  /* The deadline passed before the scan finished. */
+		cancelled  /* The scan was cancelled before it finished. */
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanLimit Struct
+	/// 	Deadline and cancellation of a limited scan. Checked before every region and every
+	/// 	SCAN_BLOCK_SIZE bytes, so a scan stops within one block of the limit.
+	///----------------------------------------------------------------------------------------------------
+	struct ScanLimit
+	{
+		std::chrono::steady_clock::time_point Deadline  = std::chrono::steady_clock::time_point::max();
+		const std::atomic<bool>*              Cancelled = nullptr;
+#ifdef MEMTOOLS_HAS_STOP_TOKEN
+		std::stop_token                       StopToken;
+#endif
+
+		///----------------------------------------------------------------------------------------------------
+		/// Until:
+		/// 	Stops at the given point in time.
+		///----------------------------------------------------------------------------------------------------
+		static inline ScanLimit Until(std::chrono::steady_clock::time_point aDeadline)
+		{
+			ScanLimit limit;
+			limit.Deadline = aDeadline;
+			return limit;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// For:
+		/// 	Stops after the given duration, starting now.
+		///----------------------------------------------------------------------------------------------------
+		static inline ScanLimit For(std::chrono::steady_clock::duration aTimeout)
+		{
+			return Until(std::chrono::steady_clock::now() + aTimeout);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Cancellable:
+		/// 	Stops once the flag is set. The flag must outlive the scan.
+		///----------------------------------------------------------------------------------------------------
+		static inline ScanLimit Cancellable(const std::atomic<bool>& aCancelled)
+		{
+			ScanLimit limit;
+			limit.Cancelled = &aCancelled;
+			return limit;
+		}
+
+#ifdef MEMTOOLS_HAS_STOP_TOKEN
+		///----------------------------------------------------------------------------------------------------
+		/// Cancellable:
+		/// 	Stops once a stop is requested on the token.
+		///----------------------------------------------------------------------------------------------------
+		static inline ScanLimit Cancellable(std::stop_token aStopToken)
+		{
+			ScanLimit limit;
+			limit.StopToken = std::move(aStopToken);
+			return limit;
+		}
+#endif
+
+		///----------------------------------------------------------------------------------------------------
+		/// Expired:
+		/// 	Returns true and sets aStatus to timedOut or cancelled if the scan has to stop.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Expired(EScanStatus& aStatus) const
+		{
+			bool cancelled = this->Cancelled && this->Cancelled->load(std::memory_order_relaxed);
+
+#ifdef MEMTOOLS_HAS_STOP_TOKEN
+			cancelled = cancelled || this->StopToken.stop_requested();
+#endif
+
+			if (cancelled)
+			{
+				aStatus = EScanStatus::cancelled;
+				return true;
+			}
+
+			if (this->Deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= this->Deadline)
+			{
+				aStatus = EScanStatus::timedOut;
+				return true;
+			}
+
+			return false;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanOutcome Struct
+	/// 	Result of a limited scan. Tells a timed out or cancelled scan apart from one that found nothing.
+	///----------------------------------------------------------------------------------------------------
+	struct ScanOutcome
+	{
+		EScanStatus Status  = EScanStatus::notFound;
+		void*       Address = nullptr;
+
+		template <typename T = void*>
+		inline T Get() const { return (T)this->Address; }
+
+		inline explicit operator bool() const { return this->Status == EScanStatus::found; }
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanWindow Struct
+	/// 	Range [Begin, End) relative to an anchor address, e.g. the result of a parent signature.
+	///----------------------------------------------------------------------------------------------------
+	struct ScanWindow
+	{
+		int64_t Begin      = 0;
+		int64_t End        = 0;
+		bool    InFunction = false; /* the function containing the anchor instead, see FunctionContaining */
+
+		///----------------------------------------------------------------------------------------------------
+		/// Within:
+		/// 	aDistance bytes before and after the anchor.
+		///----------------------------------------------------------------------------------------------------
+		static constexpr ScanWindow Within(int64_t aDistance) { return ScanWindow{ -aDistance, aDistance }; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// After:
+		/// 	aDistance bytes starting at the anchor.
+		///----------------------------------------------------------------------------------------------------
+		static constexpr ScanWindow After(int64_t aDistance) { return ScanWindow{ 0, aDistance }; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// Before:
+		/// 	aDistance bytes ending at the anchor.
+		///----------------------------------------------------------------------------------------------------
+		static constexpr ScanWindow Before(int64_t aDistance) { return ScanWindow{ -aDistance, 0 }; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// Function:
+		/// 	The function containing the anchor, from the unwind data of its module.
+		///----------------------------------------------------------------------------------------------------
+		static constexpr ScanWindow Function() { return ScanWindow{ 0, 0, true }; }
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Executor:
+	/// 	Runs a task, now or later, on any thread. Used by the asynchronous scans.
+	///----------------------------------------------------------------------------------------------------
+	using Executor = std::function<void(std::function<void()>)>;
+
+	///----------------------------------------------------------------------------------------------------
+	/// ThreadExecutor:
+	/// 	Runs every task on its own detached thread.
+	///----------------------------------------------------------------------------------------------------
+	inline Executor ThreadExecutor()
+	{
+		return [](std::function<void()> aTask)
+		{
+			std::thread(std::move(aTask)).detach();
+		};
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// InlineExecutor:
+	/// 	Runs every task immediately on the calling thread.
+	///----------------------------------------------------------------------------------------------------
+	inline Executor InlineExecutor()
+	{
+		return [](std::function<void()> aTask)
+		{
+			aTask();
+		};
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// DefaultExecutor:
+	/// 	Holds the executor used when none is passed. Defaults to the ThreadExecutor.
+	///----------------------------------------------------------------------------------------------------
+	struct DefaultExecutor
+	{
+		static inline Executor Get()
+		{
+			const std::lock_guard<std::mutex> lock(Mutex());
+			return Storage() ? Storage() : ThreadExecutor();
+		}
+
+		static inline void Set(Executor aExecutor)
+		{
+			const std::lock_guard<std::mutex> lock(Mutex());
+			Storage() = std::move(aExecutor);
+		}
+
+	private:
+		static inline std::mutex& Mutex()
+		{
+			static std::mutex s_Mutex;
+			return s_Mutex;
+		}
+
+		static inline Executor& Storage()
+		{
+			static Executor s_Executor;
+			return s_Executor;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// RunAsync:
+	/// 	Runs aWork on aExecutor and returns a future of its result.
+	///----------------------------------------------------------------------------------------------------
+	template <typename T, typename Fn>
+	inline std::future<T> RunAsync(const Executor& aExecutor, Fn aWork)
+	{
+		auto promise = std::make_shared<std::promise<T>>();
+
+		std::future<T> future = promise->get_future();
+
+		aExecutor([promise, aWork = std::move(aWork)]() mutable
+		{
+			try
+			{
+				promise->set_value(aWork());
+			}
+			catch (...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+		});
+
+		return future;
+	}
+
+#ifdef MEMTOOLS_HAS_COROUTINES
+	///----------------------------------------------------------------------------------------------------
+	/// ScanAwaitable Struct
+	/// 	co_await suspends the coroutine, runs the scan on the executor and resumes the coroutine on
+	/// 	the executor's thread with the result. If the scan completes before the executor returns,
+	/// 	e.g. on the InlineExecutor, the coroutine continues on its own thread instead.
+	///----------------------------------------------------------------------------------------------------
+	template <typename T>
+	struct ScanAwaitable
+	{
+		std::function<T()> Work;
+		Executor           Exec;
+		T                  Result{};
+		std::exception_ptr Error;
+		std::atomic<bool>  Arrived{ false }; /* set by the first of the scan and await_suspend to finish */
+
+		inline ScanAwaitable(std::function<T()> aWork, Executor aExecutor)
+			: Work(std::move(aWork)), Exec(std::move(aExecutor))
+		{
+		}
+
+		inline bool await_ready() const noexcept { return false; }
+
+		inline bool await_suspend(std::coroutine_handle<> aHandle)
+		{
+			/* The awaitable lives in the coroutine frame, which may be gone once the coroutine was resumed. */
+			Executor exec = std::move(this->Exec);
+
+			exec([this, aHandle]()
+			{
+				try
+				{
+					this->Result = this->Work();
+				}
+				catch (...)
+				{
+					this->Error = std::current_exception();
+				}
+
+				/* Only resume once await_suspend has returned, it continues the coroutine itself otherwise. */
+				if (this->Arrived.exchange(true, std::memory_order_acq_rel)) { aHandle.resume(); }
+			});
+
+			return !this->Arrived.exchange(true, std::memory_order_acq_rel);
+		}
+
+		inline T await_resume()
+		{
+			if (this->Error) { std::rethrow_exception(this->Error); }
+
+			return this->Result;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Generator Struct
+	/// 	Minimal lazy sequence for range-based for loops, until std::generator is available.
+	///----------------------------------------------------------------------------------------------------
+	template <typename T>
+	struct Generator
+	{
+		struct promise_type
+		{
+			T Current{};
+
+			inline Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			inline std::suspend_always initial_suspend() noexcept { return {}; }
+			inline std::suspend_always final_suspend() noexcept { return {}; }
+			inline std::suspend_always yield_value(T aValue) noexcept { this->Current = aValue; return {}; }
+			inline void return_void() noexcept {}
+			inline void unhandled_exception() { throw; }
+		};
+
+		struct iterator
+		{
+			std::coroutine_handle<promise_type> Handle;
+
+			inline iterator& operator++() { this->Handle.resume(); return *this; }
+			inline T operator*() const { return this->Handle.promise().Current; }
+			inline bool operator==(std::default_sentinel_t) const { return !this->Handle || this->Handle.done(); }
+		};
+
+		inline explicit Generator(std::coroutine_handle<promise_type> aHandle) : Handle(aHandle) {}
+		inline Generator(Generator&& aOther) noexcept : Handle(std::exchange(aOther.Handle, nullptr)) {}
+		Generator(const Generator&) = delete;
+		Generator& operator=(const Generator&) = delete;
+
+		inline ~Generator()
+		{
+			if (this->Handle) { this->Handle.destroy(); }
+		}
+
+		inline iterator begin()
+		{
+			if (this->Handle) { this->Handle.resume(); }
+			return iterator{ this->Handle };
+		}
+
+		inline std::default_sentinel_t end() const { return {}; }
+
+	private:
+		std::coroutine_handle<promise_type> Handle;
+	};
+#endif
+
+	///----------------------------------------------------------------------------------------------------
+	/// PatternScan Struct
+	///----------------------------------------------------------------------------------------------------
+	struct PatternScan
+	{
+		Pattern                                         Assembly;
+		std::array<Instruction, MAX_INSTRUCTION_LENGTH> Instructions = {};
+		std::size_t                                     Count        = 0;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		template<typename... Instrs>
+		constexpr PatternScan(Pattern aASM, Instrs... instrs)
+			: Assembly(aASM)
+			, Instructions{ instrs... }
+			, Count(sizeof...(Instrs))
+		{
+			static_assert(sizeof...(Instrs) <= MAX_INSTRUCTION_LENGTH, "Too many instructions for PatternScan.");
+		}
+
+		template<typename... Instrs>
+		constexpr PatternScan(PatternScan aScan, Instrs... instrs)
+			: Assembly(aScan.Assembly)
+			, Instructions(aScan.Instructions)
+			, Count(aScan.Count + sizeof...(Instrs))
+		{
+			std::size_t idx = aScan.Count;
+			for (const Instruction instr : {instrs...})
+			{
+				if (idx > MAX_INSTRUCTION_LENGTH)
+					throw "Too many instructions for PatternScan.";
+				Instructions[idx++] = instr;
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Execute:
+		/// 	Runs the instructions on a pattern match and returns the resulting address.
+		/// 	Returns nullptr if any instruction failed. Captures are stored in aResult, if given.
+		///----------------------------------------------------------------------------------------------------
+		inline void* Execute(PBYTE aMatch, ScanResult* aResult = nullptr) const
+		{
+			void* resultAddr = aMatch;
+
+			std::vector<void*> addrStore{};
+
+			/* Track offsets for wildcard advancing. */
+			int64_t offsetFromMatch = 0;
+
+			for (std::size_t idx = 0; idx < this->Count; idx++)
+			{
+				const Instruction& inst = this->Instructions[idx];
+
+				bool failed = false;
+
+				switch (inst.Operation)
+				{
+					case EOperation::offset:
+					{
+						offsetFromMatch += inst.Value;
+						resultAddr = (PBYTE)resultAddr + inst.Value;
+						break;
+					}
+					case EOperation::follow:
+					{
+						resultAddr = FollowRelativeAddress((PBYTE)resultAddr);
+						break;
+					}
+					case EOperation::strcmp:
+					{
+						failed = strcmp((const char*)FollowRelativeAddress(resultAddr), inst.String) != 0;
+						break;
+					}
+					case EOperation::wcscmp:
+					{
+						failed = wcscmp((const wchar_t*)FollowRelativeAddress(resultAddr), inst.WString) != 0;
+						break;
+					}
+					case EOperation::cmpi8:
+					{
+						failed = *((int8_t*)resultAddr) != (int8_t)inst.Value;
+						break;
+					}
+					case EOperation::cmpi16:
+					{
+						failed = *((int16_t*)resultAddr) != (int16_t)inst.Value;
+						break;
+					}
+					case EOperation::cmpi32:
+					{
+						failed = *((int32_t*)resultAddr) != (int32_t)inst.Value;
+						break;
+					}
+					case EOperation::cmpi64:
+					{
+						failed = *((int64_t*)resultAddr) != (int64_t)inst.Value;
+						break;
+					}
+					case EOperation::pushaddr:
+					{
+						addrStore.push_back(resultAddr);
+						break;
+					}
+					case EOperation::popaddr:
+					{
+						resultAddr = addrStore.back();
+						addrStore.pop_back();
+						break;
+					}
+					case EOperation::advwcard:
+					{
+						/* Advance as many sets as in the parameter. */
+						for (int64_t i = 0; i < inst.Value; i++)
+						{
+							if (offsetFromMatch >= (int64_t)this->Assembly.Size) { break; }
+
+							bool wasAtWildcard = this->Assembly[offsetFromMatch].IsWildcard;
+
+							while (offsetFromMatch < (int64_t)this->Assembly.Size)
+							{
+								if (wasAtWildcard && this->Assembly[offsetFromMatch].IsWildcard)
+								{
+									offsetFromMatch++;
+								}
+								else if (!wasAtWildcard && this->Assembly[offsetFromMatch].IsWildcard)
+								{
+									break;
+								}
+								else
+								{
+									offsetFromMatch++;
+									wasAtWildcard = false;
+								}
+							}
+						}
+
+						resultAddr = aMatch + offsetFromMatch;
+
+						break;
+					}
+					case EOperation::followinstr:
+					{
+						DecodedInstruction decoded;
+
+						failed = !DecodeInstruction((PBYTE)resultAddr, 15, decoded);
+
+						if (!failed)
+						{
+							resultAddr = GetRelativeTarget((PBYTE)resultAddr, decoded);
+							failed = resultAddr == nullptr;
+						}
+
+						break;
+					}
+					case EOperation::advinstr:
+					{
+						for (int64_t i = 0; i < inst.Value && !failed; i++)
+						{
+							DecodedInstruction decoded;
+
+							failed = !DecodeInstruction((PBYTE)resultAddr, 15, decoded);
+
+							if (!failed)
+							{
+								offsetFromMatch += decoded.Length;
+								resultAddr = (PBYTE)resultAddr + decoded.Length;
+							}
+						}
+
+						break;
+					}
+					case EOperation::capaddr:
+					{
+						if (aResult) { aResult->Captures[aResult->Count++] = (uint64_t)(uintptr_t)resultAddr; }
+						break;
+					}
+					case EOperation::capi32:
+					{
+						if (aResult) { aResult->Captures[aResult->Count++] = (uint64_t)(int64_t)*((int32_t*)resultAddr); }
+						break;
+					}
+					case EOperation::capfollow:
+					{
+						if (aResult) { aResult->Captures[aResult->Count++] = (uint64_t)(uintptr_t)FollowRelativeAddress((PBYTE)resultAddr); }
+						break;
+					}
+					default:
+						break;
+				}
+
+				if (failed)
+				{
+					/* interrupt if any failed */
+					return nullptr;
+				}
+			}
+
+			return resultAddr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanRange:
+		/// 	Scans the given memory range for the pattern and returns the pointer of the first match
+		/// 	for which all instructions succeed.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanRange(PBYTE aBase, uint64_t aSize) const
+		{
+			uint64_t offset = 0;
+
+			while (PBYTE match = FindPattern(this->Assembly, aBase, aSize, offset))
+			{
+				if (void* result = this->Execute(match))
+				{
+					return (T)result;
+				}
+
+				/* Instructions failed, continue after this match. */
+				offset = (uint64_t)(match - aBase) + 1;
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanRangeLimited:
+		/// 	Like ScanRange, but stops once aLimit expires. Checks the limit every SCAN_BLOCK_SIZE bytes.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanOutcome ScanRangeLimited(PBYTE aBase, uint64_t aSize, const ScanLimit& aLimit) const
+		{
+			ScanOutcome outcome;
+			uint64_t    offset = 0;
+
+			for (uint64_t blockStart = 0; blockStart < aSize; blockStart += SCAN_BLOCK_SIZE)
+			{
+				if (aLimit.Expired(outcome.Status)) { return outcome; }
+
+				uint64_t blockEnd = std::min(aSize, blockStart + SCAN_BLOCK_SIZE);
+				uint64_t limit    = std::min(aSize, blockEnd + this->Assembly.Size - 1);
+
+				while (PBYTE match = FindPattern(this->Assembly, aBase, limit, offset))
+				{
+					uint64_t matchOffset = (uint64_t)(match - aBase);
+
+					if (matchOffset >= blockEnd) { break; }
+
+					if (void* result = this->Execute(match))
+					{
+						outcome.Status = EScanStatus::found;
+						outcome.Address = result;
+						return outcome;
+					}
+
+					offset = matchOffset + 1;
+				}
+
+				offset = std::max(offset, blockEnd);
+			}
+
+			return outcome;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanLimited:
+		/// 	Like Scan, but stops once aLimit expires, with the status timedOut or cancelled.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanOutcome ScanLimited(const ScanLimit& aLimit) const
+		{
+			ScanOutcome outcome;
+
+			if (this->Assembly.Size == 0) { return outcome; }
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				outcome = this->ScanRangeLimited(aBase, aSize, aLimit);
+				return outcome.Status == EScanStatus::notFound;
+			});
+
+			return outcome;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanCaptures:
+		/// 	Like ScanRange, but returns the captured values of the match along with its address.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanResult ScanCaptures(PBYTE aBase, uint64_t aSize) const
+		{
+			uint64_t offset = 0;
+
+			while (PBYTE match = FindPattern(this->Assembly, aBase, aSize, offset))
+			{
+				ScanResult result;
+				result.Address = this->Execute(match, &result);
+
+				if (result.Address)
+				{
+					return result;
+				}
+
+				offset = (uint64_t)(match - aBase) + 1;
+			}
+
+			return ScanResult();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanCaptures:
+		/// 	Like Scan, but returns the captured values of the match along with its address.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanResult ScanCaptures() const
+		{
+			ScanResult result;
+
+			if (this->Assembly.Size == 0) { return result; }
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				result = this->ScanCaptures(aBase, aSize);
+				return !result;
+			});
+
+			return result;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans for the memory pattern and returns its pointer if found.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan() const
+		{
+			if (this->Assembly.Size == 0) { return nullptr; }
+
+			void* resultAddr = nullptr;
+
+			PBYTE addr = 0;
+
+#ifdef ENABLE_PATTERN_CACHING
+			struct PatternMatch
+			{
+				memtools::Pattern Pattern;
+				void*             Address;
+			};
+
+			static std::mutex                s_PatternMatchMutex;
+			static std::vector<PatternMatch> s_PatternMatchStore;
+
+			{
+				const std::lock_guard<std::mutex> lock(s_PatternMatchMutex);
+				auto it = std::find_if(s_PatternMatchStore.begin(), s_PatternMatchStore.end(), [this](const PatternMatch& match)
+				{
+					return match.Pattern == this->Assembly;
+				});
+
+				/* If stored, start from stored address. */
+				if (it != s_PatternMatchStore.end())
+				{
+					addr = (PBYTE)it->Address;
+				}
+			}
+#endif
+
+			ForEachRegion(addr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				uint64_t offset = 0;
+
+				while (PBYTE match = FindPattern(this->Assembly, aBase, aSize, offset))
+				{
+#ifdef ENABLE_PATTERN_CACHING
+					{
+						const std::lock_guard<std::mutex> lock(s_PatternMatchMutex);
+						auto it = std::find_if(s_PatternMatchStore.begin(), s_PatternMatchStore.end(), [this](const PatternMatch& match)
+						{
+							return match.Pattern == this->Assembly;
+						});
+
+						/* If not stored, store the first match. Views may refer to freed bytes later, so store a copy. */
+						if (it == s_PatternMatchStore.end())
+						{
+							s_PatternMatchStore.push_back(PatternMatch{ memtools::Pattern(this->Assembly.Data(), this->Assembly.Size), match });
+						}
+					}
+#endif
+
+					resultAddr = this->Execute(match);
+
+					if (resultAddr)
+					{
+						/* the instructions were all executed, we interrupt the region iteration */
+						return false;
+					}
+
+					offset = (uint64_t)(match - aBase) + 1;
+				}
+
+				return true;
+			});
+
+			return (T)resultAddr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the regions of a region map, without querying the regions again.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(RegionMap& aMap) const
+		{
+			if (this->Assembly.Size == 0) { return (T)nullptr; }
+
+			for (const RegionMap::Region& region : aMap.GetRegions())
+			{
+				if (void* result = this->ScanRange(region.Base, region.Size))
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAround:
+		/// 	Scans only the window around aAnchor. Matches lie completely inside the window and its
+		/// 	mapped, executable parts.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanAround(const void* aAnchor, ScanWindow aWindow) const
+		{
+			if (this->Assembly.Size == 0 || !aAnchor) { return (T)nullptr; }
+
+			if (aWindow.InFunction)
+			{
+				FunctionBounds function = FunctionContaining(aAnchor);
+
+				return function ? (T)this->ScanRange(function.Begin, (uint64_t)(function.End - function.Begin)) : (T)nullptr;
+			}
+
+			if (aWindow.End <= aWindow.Begin) { return (T)nullptr; }
+
+			uintptr_t anchor     = (uintptr_t)aAnchor;
+			PBYTE     begin      = (PBYTE)(aWindow.Begin < 0 && (uintptr_t)-aWindow.Begin > anchor ? 0 : anchor + aWindow.Begin);
+			PBYTE     end        = (PBYTE)(anchor + aWindow.End);
+			void*     resultAddr = nullptr;
+
+			ForEachRegion(begin, [&](PBYTE aBase, uint64_t aSize)
+			{
+				PBYTE from = std::max(aBase, begin);
+				PBYTE to   = std::min(aBase + aSize, end);
+
+				if (from < to)
+				{
+					resultAddr = this->ScanRange(from, (uint64_t)(to - from));
+				}
+
+				return resultAddr == nullptr;
+			}, end);
+
+			return (T)resultAddr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanModule:
+		/// 	Scans only the executable sections of a loaded module.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanModule(PBYTE aModule) const
+		{
+			if (this->Assembly.Size == 0 || !aModule) { return (T)nullptr; }
+
+			for (const Range& section : GetExecutableSections(aModule))
+			{
+				if (void* result = this->ScanRange(aModule + section.Offset, section.Size))
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the indexed module. Only positions of the rarest 4-byte n-gram of concrete bytes
+		/// 	in the pattern are verified. Patterns without such an n-gram scan the indexed sections.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const NgramIndex& aIndex) const
+		{
+			if (this->Assembly.Size == 0 || !aIndex.IsValid()) { return (T)nullptr; }
+
+			uint64_t                                    bestOffset = UINT64_MAX;
+			std::pair<const uint32_t*, const uint32_t*> best{ nullptr, nullptr };
+
+			for (uint64_t j = 0; j + 4 <= this->Assembly.Size; j++)
+			{
+				const Byte* bytes = &this->Assembly[j];
+
+				if (!bytes[0].IsExact() || !bytes[1].IsExact() || !bytes[2].IsExact() || !bytes[3].IsExact())
+				{
+					continue;
+				}
+
+				uint32_t ngram = (uint32_t)bytes[0].Value | ((uint32_t)bytes[1].Value << 8) | ((uint32_t)bytes[2].Value << 16) | ((uint32_t)bytes[3].Value << 24);
+
+				auto candidates = aIndex.Find(ngram);
+
+				if (bestOffset == UINT64_MAX || candidates.second - candidates.first < best.second - best.first)
+				{
+					bestOffset = j;
+					best = candidates;
+				}
+			}
+
+			if (bestOffset == UINT64_MAX)
+			{
+				/* No n-gram to look up, scan the indexed sections. */
+				for (const Range& section : aIndex.Sections)
+				{
+					if (void* result = this->ScanRange(aIndex.ModuleBase + section.Offset, section.Size))
+					{
+						return (T)result;
+					}
+				}
+
+				return (T)nullptr;
+			}
+
+			for (const uint32_t* it = best.first; it != best.second; it++)
+			{
+				if (*it < bestOffset) { continue; }
+
+				uint64_t     start   = *it - bestOffset;
+				const Range* section = aIndex.SectionOf(*it);
+
+				/* The whole pattern must lie within the section of the n-gram. */
+				if (!section || start < section->Offset || start + this->Assembly.Size > section->Offset + section->Size)
+				{
+					continue;
+				}
+
+				PBYTE match = aIndex.ModuleBase + start;
+
+				if (this->Assembly == match)
+				{
+					if (void* result = this->Execute(match))
+					{
+						return (T)result;
+					}
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the image bound to a suffix index. Only the matches found by the index are verified.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const SuffixIndex& aIndex) const
+		{
+			if (this->Assembly.Size == 0 || !aIndex.IsValid() || !aIndex.ImageBase) { return (T)nullptr; }
+
+			for (uint64_t offset : aIndex.FindAll(this->Assembly))
+			{
+				if (void* result = this->Execute(aIndex.ImageBase + offset))
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the memory of a page summary, skipping pages that can't contain the pattern.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const PageSummary& aSummary) const
+		{
+			if (this->Assembly.Size == 0) { return (T)nullptr; }
+
+			void* resultAddr = nullptr;
+
+			aSummary.ForEachCandidateRun(this->Assembly, [&](PBYTE aBase, uint64_t aSize)
+			{
+				resultAddr = this->ScanRange(aBase, aSize);
+				return resultAddr == nullptr;
+			});
+
+			return (T)resultAddr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the range of an instruction map, only accepting matches at instruction starts.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const InstructionMap& aMap) const
+		{
+			uint64_t offset = 0;
+
+			while (PBYTE match = FindPattern(this->Assembly, aMap.Base, aMap.Size, offset))
+			{
+				if (aMap.IsStart(match))
+				{
+					if (void* result = this->Execute(match))
+					{
+						return (T)result;
+					}
+				}
+
+				offset = (uint64_t)(match - aMap.Base) + 1;
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanFunction:
+		/// 	Scans only the function containing aAddress, see FunctionContaining.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanFunction(const void* aAddress) const
+		{
+			return this->ScanAround<T>(aAddress, ScanWindow::Function());
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans the executable sections of the module of a function table, rejecting matches that
+		/// 	span two functions.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const FunctionTable& aTable) const
+		{
+			if (this->Assembly.Size == 0 || !aTable.Base) { return (T)nullptr; }
+
+			for (const Range& section : GetExecutableSections(aTable.Base))
+			{
+				PBYTE    base   = aTable.Base + section.Offset;
+				uint64_t offset = 0;
+
+				while (PBYTE match = FindPattern(this->Assembly, base, section.Size, offset))
+				{
+					if (!aTable.Crosses((uint64_t)(match - aTable.Base), this->Assembly.Size))
+					{
+						if (void* result = this->Execute(match))
+						{
+							return (T)result;
+						}
+					}
+
+					offset = (uint64_t)(match - base) + 1;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindAll:
+		/// 	Scans every region and returns the results of all matches for which all instructions succeed.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline std::vector<T> FindAll() const
+		{
+			std::vector<T> results;
+
+			if (this->Assembly.Size == 0) { return results; }
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				uint64_t offset = 0;
+
+				while (PBYTE match = FindPattern(this->Assembly, aBase, aSize, offset))
+				{
+					if (void* result = this->Execute(match))
+					{
+						results.push_back((T)result);
+					}
+
+					offset = (uint64_t)(match - aBase) + 1;
+				}
+
+				return true;
+			});
+
+			return results;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAsync:
+		/// 	Runs Scan() on the executor and returns a future of its result.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline std::future<T> ScanAsync(const Executor& aExecutor = DefaultExecutor::Get()) const
+		{
+			return RunAsync<T>(aExecutor, [scan = *this]() { return scan.Scan<T>(); });
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindAllAsync:
+		/// 	Runs FindAll() on the executor and returns a future of its results.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline std::future<std::vector<T>> FindAllAsync(const Executor& aExecutor = DefaultExecutor::Get()) const
+		{
+			return RunAsync<std::vector<T>>(aExecutor, [scan = *this]() { return scan.FindAll<T>(); });
+		}
+
+#ifdef MEMTOOLS_HAS_COROUTINES
+		///----------------------------------------------------------------------------------------------------
+		/// Await:
+		/// 	Returns an awaitable running Scan() on the executor: void* addr = co_await scan.Await();
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline ScanAwaitable<T> Await(const Executor& aExecutor = DefaultExecutor::Get()) const
+		{
+			return ScanAwaitable<T>{ [scan = *this]() { return scan.Scan<T>(); }, aExecutor };
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindEach:
+		/// 	Lazy form of FindAll(). Each result is produced when the loop asks for it, so breaking
+		/// 	out early skips the rest of the scan.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline Generator<T> FindEach() const
+		{
+			return FindEachOf<T>(*this);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// FindEachOf:
+		/// 	Coroutine body of FindEach(). Takes the scan by value so the generator may outlive it.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T>
+		static inline Generator<T> FindEachOf(PatternScan aScan)
+		{
+			if (aScan.Assembly.Size == 0) { co_return; }
+
+			std::vector<std::pair<PBYTE, uint64_t>> regions;
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				regions.push_back({ aBase, aSize });
+				return true;
+			});
+
+			for (const auto& [base, size] : regions)
+			{
+				uint64_t offset = 0;
+
+				while (PBYTE match = FindPattern(aScan.Assembly, base, size, offset))
+				{
+					if (void* result = aScan.Execute(match))
+					{
+						co_yield (T)result;
+					}
+
+					offset = (uint64_t)(match - base) + 1;
+				}
+			}
+		}
+#endif
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// FallbackScan Struct
+	///----------------------------------------------------------------------------------------------------
+	struct FallbackScan
+	{
+		std::vector<PatternScan> Scans;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		inline FallbackScan(std::initializer_list<PatternScan> aScans)
+		{
+			for (const PatternScan& scan : aScans)
+			{
+				this->Scans.push_back(scan);
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Performs the datascans sequentially, returning if one succeeds. Otherwise returns nullptr.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan() const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				void* result = scan.Scan();
+
+				if (result)
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanLimited:
+		/// 	Performs the datascans sequentially until one succeeds or aLimit expires.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanOutcome ScanLimited(const ScanLimit& aLimit) const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				ScanOutcome outcome = scan.ScanLimited(aLimit);
+
+				if (outcome.Status != EScanStatus::notFound)
+				{
+					return outcome;
+				}
+			}
+
+			return ScanOutcome();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAround:
+		/// 	Performs the datascans sequentially in the window around aAnchor.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanAround(const void* aAnchor, ScanWindow aWindow) const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				if (void* result = scan.ScanAround(aAnchor, aWindow))
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanCaptures:
+		/// 	Performs the datascans sequentially, returning the captures of the first that succeeds.
+		///----------------------------------------------------------------------------------------------------
+		inline ScanResult ScanCaptures() const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				if (ScanResult result = scan.ScanCaptures())
+				{
+					return result;
+				}
+			}
+
+			return ScanResult();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Performs the datascans sequentially on the regions of a region map.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(RegionMap& aMap) const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				void* result = scan.Scan(aMap);
+
+				if (result)
+				{
+					return (T)result;
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Performs the datascans sequentially on a snapshot of (base, size) regions.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan(const std::vector<std::pair<PBYTE, uint64_t>>& aRegions) const
+		{
+			for (const PatternScan& scan : this->Scans)
+			{
+				for (const auto& [base, size] : aRegions)
+				{
+					if (void* result = scan.ScanRange(base, size))
+					{
+						return (T)result;
+					}
+				}
+			}
+
+			return (T)nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAsync:
+		/// 	Runs Scan() on the executor and returns a future of its result.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline std::future<T> ScanAsync(const Executor& aExecutor = DefaultExecutor::Get()) const
+		{
+			return RunAsync<T>(aExecutor, [scan = *this]() { return scan.Scan<T>(); });
+		}
+
+#ifdef MEMTOOLS_HAS_COROUTINES
+		///----------------------------------------------------------------------------------------------------
+		/// Await:
+		/// 	Returns an awaitable running Scan() on the executor.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline ScanAwaitable<T> Await(const Executor& aExecutor = DefaultExecutor::Get()) const
+		{
+			return ScanAwaitable<T>{ [scan = *this]() { return scan.Scan<T>(); }, aExecutor };
+		}
+#endif
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanBlocked:
+	/// 	Resolves many fallback scans in a single pass over the regions. Each region is split into
+	/// 	blocks of SCAN_BLOCK_SIZE bytes and every pending pattern is run over a block while it is
+	/// 	still cached, before moving on to the next block. Matches may overlap the end of a block by
+	/// 	the length of their pattern.
+	/// 	Returns the outcomes indexed like aScans, equal to FallbackScan::Scan(aRegions) for each.
+	/// 	aOnResult, if given, is called with the index and result as soon as a scan is resolved.
+	/// 	Once aLimit expires, unresolved scans get its status, with the best match found so far, and
+	/// 	are not passed to aOnResult.
+	///----------------------------------------------------------------------------------------------------
+	inline std::vector<ScanOutcome> ScanBlocked(const std::vector<const FallbackScan*>& aScans, const std::vector<std::pair<PBYTE, uint64_t>>& aRegions,
+		const ScanLimit& aLimit, const std::function<void(std::size_t, void*)>& aOnResult = nullptr)
+	{
+		struct Candidate
+		{
+			const PatternScan* Scan;
+			std::size_t        Group;
+			std::size_t        Index;  /* position in the fallback scan, lower wins */
+			uint64_t           Offset; /* next offset to search from in the current region */
+		};
+
+		std::vector<void*>       results(aScans.size(), nullptr);
+		std::vector<std::size_t> best(aScans.size(), SIZE_MAX);
+		std::vector<std::size_t> remaining(aScans.size(), 0);
+		std::vector<Candidate>   candidates;
+
+		for (std::size_t group = 0; group < aScans.size(); group++)
+		{
+			for (std::size_t i = 0; i < aScans[group]->Scans.size(); i++)
+			{
+				const PatternScan& scan = aScans[group]->Scans[i];
+
+				if (scan.Assembly.Size == 0) { continue; }
+
+				candidates.push_back(Candidate{ &scan, group, i, 0 });
+				remaining[group]++;
+			}
+
+			if (remaining[group] == 0 && aOnResult)
+			{
+				aOnResult(group, nullptr);
+			}
+		}
+
+		/* Drops candidates that can no longer change their result and reports finished scans. */
+		auto prune = [&](bool aAll)
+		{
+			candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](const Candidate& aCandidate)
+			{
+				if (!aAll && aCandidate.Index < best[aCandidate.Group]) { return false; }
+
+				if (--remaining[aCandidate.Group] == 0 && aOnResult)
+				{
+					aOnResult(aCandidate.Group, results[aCandidate.Group]);
+				}
+
+				return true;
+			}), candidates.end());
+		};
+
+		EScanStatus expired = EScanStatus::notFound;
+
+		for (const auto& [base, size] : aRegions)
+		{
+			for (Candidate& candidate : candidates)
+			{
+				candidate.Offset = 0;
+			}
+
+			for (uint64_t blockStart = 0; blockStart < size && !candidates.empty(); blockStart += SCAN_BLOCK_SIZE)
+			{
+				if (aLimit.Expired(expired)) { break; }
+
+				uint64_t blockEnd = std::min(size, blockStart + SCAN_BLOCK_SIZE);
+
+				for (Candidate& candidate : candidates)
+				{
+					/* A pattern earlier in the same fallback scan already matched in this block. */
+					if (candidate.Index >= best[candidate.Group]) { continue; }
+
+					const Pattern& pattern = candidate.Scan->Assembly;
+					uint64_t       limit   = std::min(size, blockEnd + pattern.Size - 1);
+
+					while (PBYTE match = FindPattern(pattern, base, limit, candidate.Offset))
+					{
+						uint64_t offset = (uint64_t)(match - base);
+
+						if (offset >= blockEnd) { break; }
+
+						if (void* result = candidate.Scan->Execute(match))
+						{
+							results[candidate.Group] = result;
+							best[candidate.Group] = candidate.Index;
+							break;
+						}
+
+						candidate.Offset = offset + 1;
+					}
+
+					candidate.Offset = std::max(candidate.Offset, blockEnd);
+				}
+
+				prune(false);
+			}
+
+			if (expired != EScanStatus::notFound) { break; }
+		}
+
+		std::vector<ScanOutcome> outcomes(aScans.size());
+
+		for (std::size_t group = 0; group < aScans.size(); group++)
+		{
+			outcomes[group].Address = results[group];
+			outcomes[group].Status  = results[group] ? EScanStatus::found : EScanStatus::notFound;
+		}
+
+		if (expired != EScanStatus::notFound)
+		{
+			for (const Candidate& candidate : candidates)
+			{
+				outcomes[candidate.Group].Status = expired;
+			}
+
+			return outcomes;
+		}
+
+		prune(true);
+
+		return outcomes;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// ScanBlocked:
+	/// 	Unlimited ScanBlocked, returning the result addresses indexed like aScans.
+	///----------------------------------------------------------------------------------------------------
+	inline std::vector<void*> ScanBlocked(const std::vector<const FallbackScan*>& aScans, const std::vector<std::pair<PBYTE, uint64_t>>& aRegions,
+		const std::function<void(std::size_t, void*)>& aOnResult = nullptr)
+	{
+		std::vector<void*> results;
+
+		for (const ScanOutcome& outcome : ScanBlocked(aScans, aRegions, ScanLimit(), aOnResult))
+		{
+			results.push_back(outcome.Address);
+		}
+
+		return results;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// IncrementalScan Struct
+	/// 	Resumable scan of a batch of fallback scans, spread over many calls to Step(). Every step
+	/// 	scans whole SCAN_BLOCK_SIZE blocks until its time budget is used up, and remembers the scan,
+	/// 	pattern, region and offset to continue from. The results are those of FallbackScan::Scan().
+	/// 	The regions are queried on the first step and must stay mapped until the scan is done.
+	///----------------------------------------------------------------------------------------------------
+	struct IncrementalScan
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		inline explicit IncrementalScan(std::vector<FallbackScan> aScans)
+			: Scans(std::move(aScans))
+			, Results(this->Scans.size(), nullptr)
+		{
+		}
+
+		inline explicit IncrementalScan(FallbackScan aScan)
+			: IncrementalScan(std::vector<FallbackScan>{ std::move(aScan) })
+		{
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Step:
+		/// 	Advances the scan for about aBudgetUs microseconds. The budget may be exceeded by the time
+		/// 	of one block. Returns true once all scans are done, also on any later call.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Step(uint64_t aBudgetUs)
+		{
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(aBudgetUs);
+
+			if (!this->RegionsQueried)
+			{
+				ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+				{
+					this->Regions.push_back({ aBase, aSize });
+					return true;
+				});
+
+				this->RegionsQueried = true;
+
+				if (std::chrono::steady_clock::now() >= deadline) { return this->IsDone(); }
+			}
+
+			if (this->IsDone()) { return true; }
+
+			while (!this->IsDone() && std::chrono::steady_clock::now() < deadline)
+			{
+				this->StepBlock();
+			}
+
+			return this->IsDone();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsDone:
+		/// 	Returns true once every scan of the batch finished.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsDone() const
+		{
+			return this->ScanIndex >= this->Scans.size();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetProgress:
+		/// 	Returns the number of finished scans of the batch.
+		///----------------------------------------------------------------------------------------------------
+		inline std::size_t GetProgress() const
+		{
+			return std::min(this->ScanIndex, this->Scans.size());
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetResult:
+		/// 	Returns the result of scan aIndex, nullptr until it is finished or if it found nothing.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T GetResult(std::size_t aIndex = 0) const
+		{
+			return (T)this->Results[aIndex];
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetResults:
+		/// 	Returns the results, indexed like the scans.
+		///----------------------------------------------------------------------------------------------------
+		inline const std::vector<void*>& GetResults() const
+		{
+			return this->Results;
+		}
+
+	private:
+		std::vector<FallbackScan>               Scans;
+		std::vector<void*>                      Results;
+		std::vector<std::pair<PBYTE, uint64_t>> Regions;
+		bool                                    RegionsQueried = false;
+
+		/* Cursor */
+		std::size_t ScanIndex    = 0; /* scan of the batch */
+		std::size_t PatternIndex = 0; /* pattern scan of the fallback scan */
+		std::size_t RegionIndex  = 0;
+		uint64_t    Offset       = 0;
+
+		///----------------------------------------------------------------------------------------------------
+		/// Advance:
+		/// 	Moves the cursor to the next pattern scan, or to the next scan of the batch.
+		///----------------------------------------------------------------------------------------------------
+		inline void Advance(bool aNextScan)
+		{
+			if (aNextScan)
+			{
+				this->ScanIndex++;
+				this->PatternIndex = 0;
+			}
+			else
+			{
+				this->PatternIndex++;
+			}
+
+			this->RegionIndex = 0;
+			this->Offset = 0;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// StepBlock:
+		/// 	Scans one block at the cursor, or moves the cursor past a finished region or scan.
+		///----------------------------------------------------------------------------------------------------
+		inline void StepBlock()
+		{
+			if (this->ScanIndex >= this->Scans.size()) { return; }
+
+			const FallbackScan& fallback = this->Scans[this->ScanIndex];
+
+			if (this->PatternIndex >= fallback.Scans.size())
+			{
+				/* Nothing found. */
+				this->Advance(true);
+				return;
+			}
+
+			const PatternScan& scan = fallback.Scans[this->PatternIndex];
+
+			if (scan.Assembly.Size == 0 || this->RegionIndex >= this->Regions.size())
+			{
+				this->Advance(false);
+				return;
+			}
+
+			const auto& [base, size] = this->Regions[this->RegionIndex];
+
+			if (this->Offset >= size)
+			{
+				this->RegionIndex++;
+				this->Offset = 0;
+				return;
+			}
+
+			uint64_t blockEnd = std::min(size, this->Offset + SCAN_BLOCK_SIZE);
+			uint64_t limit    = std::min(size, blockEnd + scan.Assembly.Size - 1);
+
+			while (PBYTE match = FindPattern(scan.Assembly, base, limit, this->Offset))
+			{
+				uint64_t offset = (uint64_t)(match - base);
+
+				if (offset >= blockEnd) { break; }
+
+				if (void* result = scan.Execute(match))
+				{
+					this->Results[this->ScanIndex] = result;
+					this->Advance(true);
+					return;
+				}
+
+				this->Offset = offset + 1;
+			}
+
+			this->Offset = std::max(this->Offset, blockEnd);
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// PatternAutomaton Struct
+	/// 	Extended pattern compiled into one finite automaton, found in a single pass over memory.
+	/// 	Besides the Pattern format it supports:
+	/// 	- bounded gaps "[2-8]" (2 to 8 arbitrary bytes) and "[4]"
+	/// 	- byte sets "{48|4C}"
+	/// 	- alternations "(8B 05 | 8B 0D ?)", also at the top level
+	/// 	The automaton is a Thompson NFA, run as a DFA whose states are built on demand and cached
+	/// 	per scan. Throws on invalid patterns, like Pattern.
+	///----------------------------------------------------------------------------------------------------
+	struct PatternAutomaton
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// Cache Struct
+		/// 	The DFA states built so far. Not thread-safe, so every scan uses its own.
+		///----------------------------------------------------------------------------------------------------
+		struct Cache
+		{
+			std::map<std::vector<int32_t>, int32_t> Ids;
+			std::vector<std::vector<int32_t>>       Sets;
+			std::vector<int32_t>                    Next;      /* 256 transitions per state, -1 if not built */
+			std::vector<uint8_t>                    Accepting;
+		};
+
+		uint64_t MinLength = 0;
+		uint64_t MaxLength = 0;
+
+		PatternAutomaton() = default;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		inline explicit PatternAutomaton(std::string_view aPattern)
+		{
+			uint64_t pos  = 0;
+			Node     root = ParseAlternation(aPattern, pos);
+
+			if (pos != aPattern.size()) { throw "Unbalanced pattern."; }
+
+			this->MinLength = root.MinLength;
+			this->MaxLength = root.MaxLength;
+
+			if (this->MinLength == 0) { throw "Pattern matches nothing."; }
+
+			this->States.push_back(State{ EStateKind::match });
+			this->Start = this->Compile(root, 0);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Find:
+		/// 	Returns the first address at or after aBase + aStart where the pattern matches, or nullptr.
+		/// 	Matches never extend past aBase + aSize.
+		///----------------------------------------------------------------------------------------------------
+		inline PBYTE Find(PBYTE aBase, uint64_t aSize, uint64_t aStart, Cache& aCache) const
+		{
+			if (this->States.empty() || aStart >= aSize) { return nullptr; }
+
+			int32_t state = this->GetStart(aCache);
+
+			for (uint64_t i = aStart; i < aSize; i++)
+			{
+				int32_t next = aCache.Next[(uint64_t)state * 256 + aBase[i]];
+
+				if (next < 0)
+				{
+					next = this->Transition(aCache, state, aBase[i]);
+				}
+
+				state = next;
+
+				if (!aCache.Accepting[state]) { continue; }
+
+				/* The earliest match ends at i. The leftmost match starts at most MaxLength before. */
+				uint64_t first = i + 1 >= aStart + this->MaxLength ? i + 1 - this->MaxLength : aStart;
+
+				for (uint64_t s = first; s + this->MinLength <= i + 1; s++)
+				{
+					if (this->MatchesAt(aBase + s, aSize - s))
+					{
+						return aBase + s;
+					}
+				}
+			}
+
+			return nullptr;
+		}
+
+		inline PBYTE Find(PBYTE aBase, uint64_t aSize, uint64_t aStart = 0) const
+		{
+			Cache cache;
+			return this->Find(aBase, aSize, aStart, cache);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// MatchesAt:
+		/// 	Returns true if a match starts at aAddress, reading at most aAvailable bytes.
+		///----------------------------------------------------------------------------------------------------
+		inline bool MatchesAt(PBYTE aAddress, uint64_t aAvailable) const
+		{
+			if (this->States.empty()) { return false; }
+
+			std::vector<int32_t> current;
+			std::vector<int32_t> next;
+			std::vector<uint8_t> seen(this->States.size());
+
+			this->AddClosure(this->Start, current, seen);
+
+			for (uint64_t k = 0; k < aAvailable && k < this->MaxLength && !current.empty(); k++)
+			{
+				std::fill(seen.begin(), seen.end(), 0);
+				next.clear();
+
+				for (int32_t index : current)
+				{
+					const State& state = this->States[index];
+
+					if (state.Kind == EStateKind::byte && state.Has(aAddress[k]))
+					{
+						this->AddClosure(state.Out, next, seen);
+					}
+				}
+
+				if (seen[0]) { return true; }
+
+				std::swap(current, next);
+			}
+
+			return false;
+		}
+
+	private:
+		static constexpr uint64_t MAX_CACHED_STATES = 4096;
+
+		enum class EStateKind
+		{
+			byte,
+			split,
+			match
+		};
+
+		///----------------------------------------------------------------------------------------------------
+		/// State Struct
+		/// 	byte: consumes a byte in Set, then continues at Out. split: continues at Out and Out1.
+		///----------------------------------------------------------------------------------------------------
+		struct State
+		{
+			EStateKind               Kind = EStateKind::match;
+			std::array<uint64_t, 4>  Set{};
+			int32_t                  Out  = -1;
+			int32_t                  Out1 = -1;
+
+			inline bool Has(uint8_t aByte) const { return (this->Set[aByte >> 6] >> (aByte & 63)) & 1; }
+		};
+
+		enum class ENodeKind
+		{
+			byte,
+			gap,
+			sequence,
+			alternation
+		};
+
+		struct Node
+		{
+			ENodeKind               Kind = ENodeKind::sequence;
+			std::array<uint64_t, 4> Set{};
+			std::vector<Node>       Children;
+			uint64_t                MinLength = 0;
+			uint64_t                MaxLength = 0;
+
+			Node() = default;
+			inline explicit Node(ENodeKind aKind) : Kind(aKind) {}
+		};
+
+		std::vector<State> States; /* state 0 is the match state */
+		int32_t            Start = -1;
+
+		///----------------------------------------------------------------------------------------------------
+		/// Parsing
+		///----------------------------------------------------------------------------------------------------
+		static inline void SkipSpaces(std::string_view aText, uint64_t& aPos)
+		{
+			while (aPos < aText.size() && (aText[aPos] == ' ' || aText[aPos] == '<' || aText[aPos] == '>')) { aPos++; }
+		}
+
+		static inline uint64_t ParseNumber(std::string_view aText, uint64_t& aPos)
+		{
+			uint64_t value  = 0;
+			uint64_t digits = 0;
+
+			for (; aPos < aText.size() && aText[aPos] >= '0' && aText[aPos] <= '9'; aPos++, digits++)
+			{
+				value = value * 10 + (aText[aPos] - '0');
+			}
+
+			if (digits == 0 || value > 4096) { throw "Invalid gap."; }
+
+			return value;
+		}
+
+		static inline Node ParseByte(std::string_view aText, uint64_t& aPos)
+		{
+			auto at = [&](uint64_t aIndex) { return aIndex < aText.size() ? aText[aIndex] : '\0'; };
+
+			char a  = at(aPos);
+			char b  = at(aPos + 1);
+			int  hi = parser::HexValue(a);
+			int  lo = parser::HexValue(b);
+
+			Byte byte{};
+
+			if (a == '?' && b == '?')           { byte = Byte{ true }; aPos += 2; }
+			else if (a == '?' && lo >= 0)       { byte = Byte{ false, (uint8_t)lo, 0x0F }; aPos += 2; }
+			else if (a == '?')                  { byte = Byte{ true }; aPos += 1; }
+			else if (hi >= 0 && lo >= 0)        { byte = Byte{ false, (uint8_t)(hi * HEXPOW_2 + lo) }; aPos += 2; }
+			else if (hi >= 0 && b == '?')       { byte = Byte{ false, (uint8_t)(hi * HEXPOW_2), 0xF0 }; aPos += 2; }
+			else if (hi >= 0)                   { byte = Byte{ false, (uint8_t)hi }; aPos += 1; }
+			else                                { throw "Invalid hexadecimal."; }
+
+			if (at(aPos) == '&')
+			{
+				int maskHi = parser::HexValue(at(aPos + 1));
+				int maskLo = parser::HexValue(at(aPos + 2));
+
+				if (maskHi < 0 || maskLo < 0) { throw "Invalid bitmask."; }
+
+				byte = Byte{ byte.IsWildcard, byte.Value, (uint8_t)(byte.Mask & (maskHi * HEXPOW_2 + maskLo)) };
+				aPos += 3;
+			}
+
+			Node node{ ENodeKind::byte };
+			node.MinLength = node.MaxLength = 1;
+
+			for (uint32_t v = 0; v < 256; v++)
+			{
+				if (byte.Matches((uint8_t)v)) { node.Set[v >> 6] |= 1ULL << (v & 63); }
+			}
+
+			return node;
+		}
+
+		static inline Node ParseSequence(std::string_view aText, uint64_t& aPos)
+		{
+			Node sequence{ ENodeKind::sequence };
+
+			while (true)
+			{
+				SkipSpaces(aText, aPos);
+
+				if (aPos >= aText.size() || aText[aPos] == '|' || aText[aPos] == ')') { break; }
+
+				Node item;
+
+				if (aText[aPos] == '(')
+				{
+					aPos++;
+					item = ParseAlternation(aText, aPos);
+
+					if (aPos >= aText.size() || aText[aPos] != ')') { throw "Unbalanced pattern."; }
+					aPos++;
+				}
+				else if (aText[aPos] == '{')
+				{
+					aPos++;
+					item = Node{ ENodeKind::byte };
+					item.MinLength = item.MaxLength = 1;
+
+					while (true)
+					{
+						SkipSpaces(aText, aPos);
+						Node member = ParseByte(aText, aPos);
+						for (int w = 0; w < 4; w++) { item.Set[w] |= member.Set[w]; }
+						SkipSpaces(aText, aPos);
+
+						if (aPos < aText.size() && aText[aPos] == '|') { aPos++; continue; }
+						if (aPos < aText.size() && aText[aPos] == '}') { aPos++; break; }
+
+						throw "Invalid byte set.";
+					}
+				}
+				else if (aText[aPos] == '[')
+				{
+					aPos++;
+					item = Node{ ENodeKind::gap };
+					item.MinLength = item.MaxLength = ParseNumber(aText, aPos);
+
+					if (aPos < aText.size() && aText[aPos] == '-')
+					{
+						aPos++;
+						item.MaxLength = ParseNumber(aText, aPos);
+					}
+
+					if (aPos >= aText.size() || aText[aPos] != ']' || item.MaxLength < item.MinLength) { throw "Invalid gap."; }
+					aPos++;
+				}
+				else
+				{
+					item = ParseByte(aText, aPos);
+				}
+
+				sequence.MinLength += item.MinLength;
+				sequence.MaxLength += item.MaxLength;
+				sequence.Children.push_back(std::move(item));
+			}
+
+			return sequence;
+		}
+
+		static inline Node ParseAlternation(std::string_view aText, uint64_t& aPos)
+		{
+			Node alternation{ ENodeKind::alternation };
+			alternation.MinLength = UINT64_MAX;
+
+			while (true)
+			{
+				Node branch = ParseSequence(aText, aPos);
+
+				if (branch.Children.empty()) { throw "Empty alternative."; }
+
+				alternation.MinLength = std::min(alternation.MinLength, branch.MinLength);
+				alternation.MaxLength = std::max(alternation.MaxLength, branch.MaxLength);
+				alternation.Children.push_back(std::move(branch));
+
+				if (aPos < aText.size() && aText[aPos] == '|')
+				{
+					aPos++;
+					continue;
+				}
+
+				break;
+			}
+
+			return alternation;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Compile:
+		/// 	Adds the states of a node, continuing at aNext, and returns its first state.
+		///----------------------------------------------------------------------------------------------------
+		inline int32_t Compile(const Node& aNode, int32_t aNext)
+		{
+			auto add = [this](State aState)
+			{
+				this->States.push_back(aState);
+				return (int32_t)this->States.size() - 1;
+			};
+
+			std::array<uint64_t, 4> any{ ~0ULL, ~0ULL, ~0ULL, ~0ULL };
+
+			switch (aNode.Kind)
+			{
+				case ENodeKind::byte:
+				{
+					return add(State{ EStateKind::byte, aNode.Set, aNext });
+				}
+				case ENodeKind::gap:
+				{
+					int32_t current = aNext;
+
+					/* Optional bytes first, built backwards. */
+					for (uint64_t i = aNode.MinLength; i < aNode.MaxLength; i++)
+					{
+						int32_t consume = add(State{ EStateKind::byte, any, current });
+						current = add(State{ EStateKind::split, {}, consume, current });
+					}
+
+					for (uint64_t i = 0; i < aNode.MinLength; i++)
+					{
+						current = add(State{ EStateKind::byte, any, current });
+					}
+
+					return current;
+				}
+				case ENodeKind::sequence:
+				{
+					int32_t current = aNext;
+
+					for (auto it = aNode.Children.rbegin(); it != aNode.Children.rend(); it++)
+					{
+						current = this->Compile(*it, current);
+					}
+
+					return current;
+				}
+				case ENodeKind::alternation:
+				default:
+				{
+					int32_t current = this->Compile(aNode.Children.back(), aNext);
+
+					for (auto it = aNode.Children.rbegin() + 1; it != aNode.Children.rend(); it++)
+					{
+						int32_t branch = this->Compile(*it, aNext);
+						current = add(State{ EStateKind::split, {}, branch, current });
+					}
+
+					return current;
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// AddClosure:
+		/// 	Adds the byte and match states reachable from aState without consuming a byte.
+		///----------------------------------------------------------------------------------------------------
+		inline void AddClosure(int32_t aState, std::vector<int32_t>& aOut, std::vector<uint8_t>& aSeen) const
+		{
+			std::vector<int32_t> stack{ aState };
+
+			while (!stack.empty())
+			{
+				int32_t index = stack.back();
+				stack.pop_back();
+
+				if (aSeen[index]) { continue; }
+				aSeen[index] = 1;
+
+				const State& state = this->States[index];
+
+				if (state.Kind == EStateKind::split)
+				{
+					stack.push_back(state.Out1);
+					stack.push_back(state.Out);
+				}
+				else
+				{
+					aOut.push_back(index);
+				}
+			}
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// AddDfaState:
+		/// 	Returns the id of the DFA state of a sorted NFA state set, adding it if new.
+		///----------------------------------------------------------------------------------------------------
+		inline int32_t AddDfaState(Cache& aCache, std::vector<int32_t> aSet) const
+		{
+			auto it = aCache.Ids.find(aSet);
+
+			if (it != aCache.Ids.end()) { return it->second; }
+
+			int32_t id = (int32_t)aCache.Sets.size();
+
+			aCache.Accepting.push_back(std::binary_search(aSet.begin(), aSet.end(), 0) ? 1 : 0);
+			aCache.Next.resize(aCache.Next.size() + 256, -1);
+			aCache.Ids.emplace(aSet, id);
+			aCache.Sets.push_back(std::move(aSet));
+
+			return id;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetStart:
+		/// 	Returns the DFA state before any byte was read. Its id is always 0.
+		///----------------------------------------------------------------------------------------------------
+		inline int32_t GetStart(Cache& aCache) const
+		{
+			if (!aCache.Sets.empty()) { return 0; }
+
+			std::vector<int32_t> set;
+			std::vector<uint8_t> seen(this->States.size());
+
+			this->AddClosure(this->Start, set, seen);
+			std::sort(set.begin(), set.end());
+
+			return this->AddDfaState(aCache, std::move(set));
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Transition:
+		/// 	Builds the DFA transition of a state on a byte. A new match may start at every byte,
+		/// 	so the start closure is always added.
+		///----------------------------------------------------------------------------------------------------
+		inline int32_t Transition(Cache& aCache, int32_t aState, uint8_t aByte) const
+		{
+			std::vector<int32_t> set;
+			std::vector<uint8_t> seen(this->States.size());
+
+			for (int32_t index : aCache.Sets[aState])
+			{
+				const State& state = this->States[index];
+
+				if (state.Kind == EStateKind::byte && state.Has(aByte))
+				{
+					this->AddClosure(state.Out, set, seen);
+				}
+			}
+
+			this->AddClosure(this->Start, set, seen);
+			std::sort(set.begin(), set.end());
+
+			/* Too many states, start over. The current transition is rebuilt from scratch. */
+			if (aCache.Sets.size() >= MAX_CACHED_STATES)
+			{
+				aCache = Cache();
+				this->GetStart(aCache);
+
+				return this->AddDfaState(aCache, std::move(set));
+			}
+
+			int32_t next = this->AddDfaState(aCache, std::move(set));
+			aCache.Next[(uint64_t)aState * 256 + aByte] = next;
+
+			return next;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// AutomatonScan Struct
+	/// 	PatternScan with a PatternAutomaton. Replaces a FallbackScan of similar patterns with a single
+	/// 	pass. Instructions run relative to the start of the match; AdvWcard is not supported.
+	///----------------------------------------------------------------------------------------------------
+	struct AutomatonScan
+	{
+		PatternAutomaton Automaton;
+		PatternScan      Program;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		template<typename... Instrs>
+		inline AutomatonScan(std::string_view aPattern, Instrs... instrs)
+			: Automaton(aPattern)
+			, Program(Pattern(), instrs...)
+		{
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanRange:
+		/// 	Scans the given memory range and returns the pointer of the first match for which all
+		/// 	instructions succeed.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T ScanRange(PBYTE aBase, uint64_t aSize) const
+		{
+			PatternAutomaton::Cache cache;
+			return (T)this->ScanRange(aBase, aSize, cache);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Scan:
+		/// 	Scans for the pattern and returns its pointer if found.
+		///----------------------------------------------------------------------------------------------------
+		template <typename T = void*>
+		inline T Scan() const
+		{
+			PatternAutomaton::Cache cache;
+			void*                   resultAddr = nullptr;
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				resultAddr = this->ScanRange(aBase, aSize, cache);
+				return resultAddr == nullptr;
+			});
+
+			return (T)resultAddr;
+		}
+
+	private:
+		inline void* ScanRange(PBYTE aBase, uint64_t aSize, PatternAutomaton::Cache& aCache) const
+		{
+			uint64_t offset = 0;
+
+			while (PBYTE match = this->Automaton.Find(aBase, aSize, offset, aCache))
+			{
+				if (void* result = this->Program.Execute(match))
+				{
+					return result;
+				}
+
+				offset = (uint64_t)(match - aBase) + 1;
+			}
+
+			return nullptr;
+		}
+	};
+
+	struct LazyAddressBase;
+
+	///----------------------------------------------------------------------------------------------------
+	/// SignatureRegistry Struct
+	/// 	Global list of all living lazy addresses. They enroll themselves on construction.
+	///----------------------------------------------------------------------------------------------------
+	struct SignatureRegistry
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// Get:
+		/// 	Returns the process-wide registry.
+		///----------------------------------------------------------------------------------------------------
+		static inline SignatureRegistry& Get()
+		{
+			static SignatureRegistry s_Registry;
+			return s_Registry;
+		}
+
+		inline void Register(LazyAddressBase* aEntry)
+		{
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+			this->Entries.push_back(aEntry);
+		}
+
+		inline void Unregister(LazyAddressBase* aEntry)
+		{
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+			this->Entries.erase(std::remove(this->Entries.begin(), this->Entries.end(), aEntry), this->Entries.end());
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetEntries:
+		/// 	Returns a copy of the registered entries.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<LazyAddressBase*> GetEntries()
+		{
+			const std::lock_guard<std::mutex> lock(this->Mutex);
+			return this->Entries;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetResolutionOrder:
+		/// 	Returns a copy of the registered entries, with every entry after its parent.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<LazyAddressBase*> GetResolutionOrder();
+
+	private:
+		std::mutex                    Mutex;
+		std::vector<LazyAddressBase*> Entries;
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// LazyAddressBase Struct
+	/// 	Resolves its scans on first access, once, and caches the result. Later reads are a single
+	/// 	acquire load without locking. A scan that found nothing stays resolved as nullptr.
+	/// 	Enrolls itself in the SignatureRegistry for as long as it lives.
+	///----------------------------------------------------------------------------------------------------
+	struct LazyAddressBase
+	{
+		FallbackScan           Scans;
+		const LazyAddressBase* Parent = nullptr; /* scans only the window around the parent, if set */
+		ScanWindow             Window;
+
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		inline LazyAddressBase(FallbackScan aScans)
+			: Scans(std::move(aScans))
+		{
+			SignatureRegistry::Get().Register(this);
+		}
+
+		inline LazyAddressBase(const LazyAddressBase& aParent, ScanWindow aWindow, FallbackScan aScans)
+			: Scans(std::move(aScans))
+			, Parent(&aParent)
+			, Window(aWindow)
+		{
+			SignatureRegistry::Get().Register(this);
+		}
+
+		LazyAddressBase(const LazyAddressBase&) = delete;
+		LazyAddressBase& operator=(const LazyAddressBase&) = delete;
+
+		///----------------------------------------------------------------------------------------------------
+		/// dtor
+		///----------------------------------------------------------------------------------------------------
+		inline ~LazyAddressBase()
+		{
+			SignatureRegistry::Get().Unregister(this);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetAddress:
+		/// 	Returns the resolved address, resolving it on the first call.
+		///----------------------------------------------------------------------------------------------------
+		inline void* GetAddress() const
+		{
+			void* addr = this->Address.load(std::memory_order_acquire);
+
+			if (addr != Unresolved())
+			{
+				return addr;
+			}
+
+			return this->Resolve();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Resolve:
+		/// 	Runs the scans if no thread has resolved the address yet and returns the address.
+		/// 	Concurrent callers wait for the first one.
+		///----------------------------------------------------------------------------------------------------
+		inline void* Resolve() const
+		{
+			std::call_once(this->Once, [this]()
+			{
+				this->Address.store(this->Search(), std::memory_order_release);
+			});
+
+			return this->Address.load(std::memory_order_acquire);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Search:
+		/// 	Runs the scans without caching the result. Resolves the parent first, if any, and finds
+		/// 	nothing if the parent found nothing.
+		///----------------------------------------------------------------------------------------------------
+		inline void* Search() const
+		{
+			if (!this->Parent)
+			{
+				return this->Scans.Scan();
+			}
+
+			void* parent = this->Parent->GetAddress();
+
+			return parent ? this->Scans.ScanAround(parent, this->Window) : nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetDepth:
+		/// 	Returns the number of parents above this address.
+		///----------------------------------------------------------------------------------------------------
+		inline std::size_t GetDepth() const
+		{
+			std::size_t depth = 0;
+
+			for (const LazyAddressBase* parent = this->Parent; parent; parent = parent->Parent)
+			{
+				depth++;
+			}
+
+			return depth;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Set:
+		/// 	Resolves the address with an externally found result, e.g. from a batched scan.
+		/// 	Returns false if the address was already resolved.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Set(void* aAddress) const
+		{
+			bool set = false;
+
+			std::call_once(this->Once, [this, aAddress, &set]()
+			{
+				this->Address.store(aAddress, std::memory_order_release);
+				set = true;
+			});
+
+			return set;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsResolved:
+		/// 	Returns true once the scans ran or an address was set.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsResolved() const
+		{
+			return this->Address.load(std::memory_order_acquire) != Unresolved();
+		}
+
+	private:
+		static inline void* Unresolved() { return (void*)UINTPTR_MAX; }
+
+		mutable std::atomic<void*> Address{ (void*)UINTPTR_MAX };
+		mutable std::once_flag     Once;
+	};
+
+	inline std::vector<LazyAddressBase*> SignatureRegistry::GetResolutionOrder()
+	{
+		std::vector<std::pair<std::size_t, LazyAddressBase*>> ordered;
+
+		for (LazyAddressBase* entry : this->GetEntries())
+		{
+			ordered.push_back({ entry->GetDepth(), entry });
+		}
+
+		std::stable_sort(ordered.begin(), ordered.end(), [](const auto& aLeft, const auto& aRight) { return aLeft.first < aRight.first; });
+
+		std::vector<LazyAddressBase*> entries;
+
+		for (const auto& [depth, entry] : ordered)
+		{
+			entries.push_back(entry);
+		}
+
+		return entries;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// LazyAddress Struct
+	/// 	Typed lazy address. Declared at namespace scope, it is resolved by PrewarmAll().
+	///----------------------------------------------------------------------------------------------------
+	template <typename T = void*>
+	struct LazyAddress : LazyAddressBase
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// ctor
+		///----------------------------------------------------------------------------------------------------
+		inline LazyAddress(const PatternScan& aScan)
+			: LazyAddressBase(FallbackScan{ aScan })
+		{
+		}
+
+		inline LazyAddress(FallbackScan aScans)
+			: LazyAddressBase(std::move(aScans))
+		{
+		}
+
+		inline LazyAddress(const LazyAddressBase& aParent, ScanWindow aWindow, const PatternScan& aScan)
+			: LazyAddressBase(aParent, aWindow, FallbackScan{ aScan })
+		{
+		}
+
+		inline LazyAddress(const LazyAddressBase& aParent, ScanWindow aWindow, FallbackScan aScans)
+			: LazyAddressBase(aParent, aWindow, std::move(aScans))
+		{
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Get:
+		/// 	Returns the resolved address, resolving it on the first call.
+		///----------------------------------------------------------------------------------------------------
+		inline T Get() const { return (T)this->GetAddress(); }
+
+		inline operator T() const { return this->Get(); }
+
+		inline explicit operator bool() const { return this->GetAddress() != nullptr; }
+
+		///----------------------------------------------------------------------------------------------------
+		/// operator():
+		/// 	Calls the resolved address, if T is a function pointer.
+		///----------------------------------------------------------------------------------------------------
+		template <typename... Args>
+		inline decltype(auto) operator()(Args&&... aArgs) const
+		{
+			return this->Get()(std::forward<Args>(aArgs)...);
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// Resolved:
+	/// 	Alias of LazyAddress.
+	///----------------------------------------------------------------------------------------------------
+	template <typename T = void*>
+	using Resolved = LazyAddress<T>;
+
+	///----------------------------------------------------------------------------------------------------
+	/// EPriority Enumeration
+	///----------------------------------------------------------------------------------------------------
+	enum class EPriority
+	{
+		low,
+		normal,
+		high
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// SetCurrentThreadPriority:
+	/// 	Adjusts the scheduling priority of the calling thread. Failures are ignored.
+	///----------------------------------------------------------------------------------------------------
+	inline void SetCurrentThreadPriority(EPriority aPriority)
+	{
+#ifdef _WIN32
+		int priority = aPriority == EPriority::low ? THREAD_PRIORITY_BELOW_NORMAL : aPriority == EPriority::high ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_NORMAL;
+		SetThreadPriority(GetCurrentThread(), priority);
+#else
+		/* Linux applies the nice value per thread. Raising it may need privileges. */
+		int nice = aPriority == EPriority::low ? 10 : aPriority == EPriority::high ? -5 : 0;
+		setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice);
+#endif
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// PrewarmAll:
+	/// 	Resolves all registered, unresolved lazy addresses in the background, on aThreads threads
+	/// 	(0 for one per core) of the given priority. The regions are queried once and shared by all
+	/// 	scans, and each address is set as soon as its scans finish.
+	/// 	The future holds the number of addresses that were found. Addresses still unresolved when
+	/// 	aLimit expires are left alone and resolve on their first access.
+	/// 	Lazy addresses must outlive the prewarm, so only declare them at namespace scope or as
+	/// 	static members.
+	///----------------------------------------------------------------------------------------------------
+	inline std::future<std::size_t> PrewarmAll(unsigned aThreads = 0, EPriority aPriority = EPriority::low, ScanLimit aLimit = ScanLimit())
+	{
+		std::vector<LazyAddressBase*> pending;
+		std::vector<LazyAddressBase*> dependent; /* ordered after their parents */
+
+		for (LazyAddressBase* entry : SignatureRegistry::Get().GetResolutionOrder())
+		{
+			if (!entry->IsResolved())
+			{
+				(entry->Parent ? dependent : pending).push_back(entry);
+			}
+		}
+
+		if (aThreads == 0)
+		{
+			aThreads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		return RunAsync<std::size_t>(ThreadExecutor(), [pending = std::move(pending), dependent = std::move(dependent), aThreads, aPriority, aLimit = std::move(aLimit)]()
+		{
+			SetCurrentThreadPriority(aPriority);
+
+			std::vector<std::pair<PBYTE, uint64_t>> regions;
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				regions.push_back({ aBase, aSize });
+				return true;
+			});
+
+			std::atomic<std::size_t> found{ 0 };
+
+			std::size_t threadCount = std::max<std::size_t>(1, std::min<std::size_t>(aThreads, pending.size()));
+
+			/* Every thread resolves a slice of the entries in one blocked pass over the regions. */
+			auto worker = [&](std::size_t aThread)
+			{
+				std::vector<LazyAddressBase*>    entries;
+				std::vector<const FallbackScan*> scans;
+
+				for (std::size_t i = pending.size() * aThread / threadCount; i < pending.size() * (aThread + 1) / threadCount; i++)
+				{
+					/* Accessed in the meantime. */
+					if (pending[i]->IsResolved()) { continue; }
+
+					entries.push_back(pending[i]);
+					scans.push_back(&pending[i]->Scans);
+				}
+
+				ScanBlocked(scans, regions, aLimit, [&](std::size_t aIndex, void* aResult)
+				{
+					entries[aIndex]->Set(aResult);
+
+					if (entries[aIndex]->GetAddress())
+					{
+						found++;
+					}
+				});
+			};
+
+			std::vector<std::thread> threads;
+
+			for (std::size_t i = 1; i < threadCount; i++)
+			{
+				threads.emplace_back([&, i]()
+				{
+					SetCurrentThreadPriority(aPriority);
+					worker(i);
+				});
+			}
+
+			worker(0);
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			/* Dependent scans only cover small windows, resolve them in order once their parents are. */
+			for (LazyAddressBase* entry : dependent)
+			{
+				EScanStatus status;
+
+				if (aLimit.Expired(status)) { break; }
+
+				if (entry->IsResolved() || !entry->Parent->IsResolved()) { continue; }
+
+				if (entry->Resolve())
+				{
+					found++;
+				}
+			}
+
+			return found.load();
+		});
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// SignatureDatabase Struct
+	/// 	Binary file of named fallback groups of compiled scans. Loading maps the file and checks its
+	/// 	bounds; patterns, instructions and strings are used from the mapping without parsing.
+	/// 	Strings of wide comparisons are stored as wchar_t, so files are specific to its size.
+	///----------------------------------------------------------------------------------------------------
+	struct SignatureDatabase
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// Entry Struct
+		/// 	Input of Write: a named PatternScan or FallbackScan.
+		///----------------------------------------------------------------------------------------------------
+		struct Entry
+		{
+			std::string  Name;
+			FallbackScan Scans;
+
+			inline Entry(std::string aName, const PatternScan& aScan) : Name(std::move(aName)), Scans{ aScan } {}
+			inline Entry(std::string aName, FallbackScan aScans) : Name(std::move(aName)), Scans(std::move(aScans)) {}
+		};
+
+		///----------------------------------------------------------------------------------------------------
+		/// Write:
+		/// 	Converts the entries to a database file. Entries are sorted by name for lookups.
+		///----------------------------------------------------------------------------------------------------
+		static inline bool Write(const char* aPath, std::vector<Entry> aEntries)
+		{
+			std::sort(aEntries.begin(), aEntries.end(), [](const Entry& aLhs, const Entry& aRhs)
+			{
+				return aLhs.Name < aRhs.Name;
+			});
+
+			std::vector<GroupRecord>       groups;
+			std::vector<ScanRecord>        scans;
+			std::vector<InstructionRecord> instructions;
+			std::vector<Byte>              bytes;
+			std::vector<uint8_t>           strings;
+
+			auto addString = [&strings](const void* aData, std::size_t aSize, std::size_t aAlign)
+			{
+				strings.resize((strings.size() + aAlign - 1) / aAlign * aAlign);
+
+				uint32_t offset = (uint32_t)strings.size();
+				strings.insert(strings.end(), (const uint8_t*)aData, (const uint8_t*)aData + aSize);
+
+				return offset;
+			};
+
+			for (const Entry& entry : aEntries)
+			{
+				groups.push_back(GroupRecord{ addString(entry.Name.c_str(), entry.Name.size() + 1, 1), (uint32_t)scans.size(), (uint32_t)entry.Scans.Scans.size(), 0 });
+
+				for (const PatternScan& scan : entry.Scans.Scans)
+				{
+					scans.push_back(ScanRecord{ (uint32_t)bytes.size(), (uint32_t)scan.Assembly.Size, (uint32_t)instructions.size(), (uint32_t)scan.Count });
+
+					bytes.insert(bytes.end(), scan.Assembly.Data(), scan.Assembly.Data() + scan.Assembly.Size);
+
+					for (std::size_t i = 0; i < scan.Count; i++)
+					{
+						const Instruction& inst = scan.Instructions[i];
+
+						InstructionRecord record{ (uint32_t)inst.Operation, NO_STRING, inst.Value };
+
+						/* Comparisons without a string can't be executed, nor loaded. */
+						if (inst.Operation == EOperation::strcmp)
+						{
+							if (!inst.String) { return false; }
+
+							record.String = addString(inst.String, strlen(inst.String) + 1, 1);
+						}
+						else if (inst.Operation == EOperation::wcscmp)
+						{
+							if (!inst.WString) { return false; }
+
+							record.String = addString(inst.WString, (wcslen(inst.WString) + 1) * sizeof(wchar_t), sizeof(wchar_t));
+						}
+
+						instructions.push_back(record);
+					}
+				}
+			}
+
+			Header header{ MAGIC, VERSION, (uint32_t)sizeof(wchar_t), 0, groups.size(), scans.size(), instructions.size(), bytes.size(), strings.size() };
+
+			FILE* file = fopen(aPath, "wb");
+
+			if (!file) { return false; }
+
+			static const uint8_t s_Padding[8]{};
+
+			/* Each table starts 8-byte aligned. */
+			auto write = [file](const void* aData, std::size_t aSize)
+			{
+				return fwrite(aData, 1, aSize, file) == aSize && fwrite(s_Padding, 1, Align(aSize) - aSize, file) == Align(aSize) - aSize;
+			};
+
+			bool success = write(&header, sizeof(header));
+			success = success && write(groups.data(), groups.size() * sizeof(GroupRecord));
+			success = success && write(scans.data(), scans.size() * sizeof(ScanRecord));
+			success = success && write(instructions.data(), instructions.size() * sizeof(InstructionRecord));
+			success = success && write(bytes.data(), bytes.size() * sizeof(Byte));
+			success = success && write(strings.data(), strings.size());
+
+			return fclose(file) == 0 && success;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Load:
+		/// 	Maps a database written with Write. Returns false if the file is invalid.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Load(const char* aPath)
+		{
+			*this = SignatureDatabase();
+
+			if (!this->File.Open(aPath)) { return false; }
+
+			const uint8_t* data = this->File.Data;
+
+			Header header;
+			if (this->File.Size < sizeof(header)) { return this->Fail(); }
+			memcpy(&header, data, sizeof(header));
+
+			if (header.Magic != MAGIC || header.Version != VERSION || header.WCharSize != sizeof(wchar_t)) { return this->Fail(); }
+
+			/* Counts are at most the file size, so the offsets can't overflow. */
+			if (header.GroupCount > this->File.Size || header.ScanCount > this->File.Size || header.InstructionCount > this->File.Size ||
+				header.ByteCount > this->File.Size || header.StringSize > this->File.Size)
+			{
+				return this->Fail();
+			}
+
+			uint64_t groupsOffset       = Align(sizeof(Header));
+			uint64_t scansOffset        = groupsOffset + Align(header.GroupCount * sizeof(GroupRecord));
+			uint64_t instructionsOffset = scansOffset + Align(header.ScanCount * sizeof(ScanRecord));
+			uint64_t bytesOffset        = instructionsOffset + Align(header.InstructionCount * sizeof(InstructionRecord));
+			uint64_t stringsOffset      = bytesOffset + Align(header.ByteCount * sizeof(Byte));
+			uint64_t end                = stringsOffset + Align(header.StringSize);
+
+			if (end != this->File.Size) { return this->Fail(); }
+
+			this->Groups           = (const GroupRecord*)(data + groupsOffset);
+			this->Scans            = (const ScanRecord*)(data + scansOffset);
+			this->Instructions     = (const InstructionRecord*)(data + instructionsOffset);
+			this->Bytes            = (const Byte*)(data + bytesOffset);
+			this->Strings          = (const char*)(data + stringsOffset);
+			this->GroupCount       = header.GroupCount;
+			this->ScanCount        = header.ScanCount;
+			this->InstructionCount = header.InstructionCount;
+			this->ByteCount        = header.ByteCount;
+			this->StringSize       = header.StringSize;
+
+			/* Check references once, so lookups can trust them. */
+			for (uint64_t i = 0; i < this->GroupCount; i++)
+			{
+				const GroupRecord& group = this->Groups[i];
+
+				if (!this->IsString(group.Name, 1, 1) || (uint64_t)group.FirstScan + group.ScanCount > this->ScanCount) { return this->Fail(); }
+			}
+
+			for (uint64_t i = 0; i < this->ScanCount; i++)
+			{
+				const ScanRecord& scan = this->Scans[i];
+
+				if ((uint64_t)scan.FirstByte + scan.ByteCount > this->ByteCount ||
+					scan.InstructionCount > MAX_INSTRUCTION_LENGTH || (uint64_t)scan.FirstInstruction + scan.InstructionCount > this->InstructionCount)
+				{
+					return this->Fail();
+				}
+
+				/* Every popaddr needs an address pushed before it. */
+				uint32_t pushed = 0;
+
+				for (uint32_t k = 0; k < scan.InstructionCount; k++)
+				{
+					EOperation op = (EOperation)this->Instructions[scan.FirstInstruction + k].Operation;
+
+					if (op == EOperation::pushaddr) { pushed++; }
+					if (op == EOperation::popaddr && pushed-- == 0) { return this->Fail(); }
+				}
+			}
+
+			/* Known operations, and a string for exactly the comparisons. */
+			for (uint64_t i = 0; i < this->InstructionCount; i++)
+			{
+				const InstructionRecord& inst = this->Instructions[i];
+
+				if (inst.Operation > (uint32_t)EOperation::capfollow) { return this->Fail(); }
+
+				bool wide      = inst.Operation == (uint32_t)EOperation::wcscmp;
+				bool hasString = wide || inst.Operation == (uint32_t)EOperation::strcmp;
+
+				if (hasString != (inst.String != NO_STRING)) { return this->Fail(); }
+
+				if (hasString && !this->IsString(inst.String, wide ? sizeof(wchar_t) : 1, wide ? sizeof(wchar_t) : 1)) { return this->Fail(); }
+			}
+
+			/* Bools must be 0 or 1. */
+			for (uint64_t i = 0; i < this->ByteCount; i++)
+			{
+				uint8_t isWildcard;
+				memcpy(&isWildcard, &this->Bytes[i], 1);
+
+				if (isWildcard > 1) { return this->Fail(); }
+			}
+
+			return true;
+		}
+
+		inline bool IsValid() const
+		{
+			return this->Groups != nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetCount:
+		/// 	Returns the number of groups.
+		///----------------------------------------------------------------------------------------------------
+		inline uint64_t GetCount() const
+		{
+			return this->GroupCount;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetName:
+		/// 	Returns the name of a group, pointing into the mapping.
+		///----------------------------------------------------------------------------------------------------
+		inline const char* GetName(uint64_t aGroup) const
+		{
+			return aGroup < this->GroupCount ? this->Strings + this->Groups[aGroup].Name : nullptr;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// Find:
+		/// 	Returns the index of the group with the name, or UINT64_MAX.
+		///----------------------------------------------------------------------------------------------------
+		inline uint64_t Find(const char* aName) const
+		{
+			const GroupRecord* first = this->Groups;
+			const GroupRecord* last  = this->Groups + this->GroupCount;
+
+			const GroupRecord* it = std::lower_bound(first, last, aName, [this](const GroupRecord& aGroup, const char* aKey)
+			{
+				return strcmp(this->Strings + aGroup.Name, aKey) < 0;
+			});
+
+			if (it == last || strcmp(this->Strings + it->Name, aName) != 0) { return UINT64_MAX; }
+
+			return (uint64_t)(it - first);
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// GetScan:
+		/// 	Returns the fallback group as a FallbackScan. Patterns and strings point into the mapping,
+		/// 	so the database must stay loaded while the scan is used.
+		///----------------------------------------------------------------------------------------------------
+		inline FallbackScan GetScan(uint64_t aGroup) const
+		{
+			FallbackScan result{};
+
+			if (aGroup >= this->GroupCount) { return result; }
+
+			const GroupRecord& group = this->Groups[aGroup];
+
+			for (uint32_t i = 0; i < group.ScanCount; i++)
+			{
+				result.Scans.push_back(this->GetPatternScan(group.FirstScan + i));
+			}
+
+			return result;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAll:
+		/// 	Resolves every group, indexed like the groups, on aThreads threads (0 for one per core).
+		/// 	The regions are queried once and shared by all groups.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<void*> ScanAll(unsigned aThreads = 0) const
+		{
+			std::vector<void*> results;
+
+			for (const ScanOutcome& outcome : this->ScanAll(ScanLimit(), aThreads))
+			{
+				results.push_back(outcome.Address);
+			}
+
+			return results;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ScanAll:
+		/// 	Like ScanAll, but stops once aLimit expires. Unfinished groups get its status.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<ScanOutcome> ScanAll(const ScanLimit& aLimit, unsigned aThreads = 0) const
+		{
+			std::vector<ScanOutcome> results(this->GroupCount);
+
+			std::vector<std::pair<PBYTE, uint64_t>> regions;
+
+			ForEachRegion(nullptr, [&](PBYTE aBase, uint64_t aSize)
+			{
+				regions.push_back({ aBase, aSize });
+				return true;
+			});
+
+			if (aThreads == 0)
+			{
+				aThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			uint64_t threadCount = std::max<uint64_t>(1, std::min<uint64_t>(aThreads, this->GroupCount));
+
+			/* Every thread resolves a slice of the groups in one blocked pass over the regions. */
+			auto worker = [&](uint64_t aThread)
+			{
+				uint64_t first = this->GroupCount * aThread / threadCount;
+				uint64_t last  = this->GroupCount * (aThread + 1) / threadCount;
+
+				std::vector<FallbackScan>        groups;
+				std::vector<const FallbackScan*> scans;
+
+				for (uint64_t i = first; i < last; i++)
+				{
+					groups.push_back(this->GetScan(i));
+				}
+
+				for (const FallbackScan& group : groups)
+				{
+					scans.push_back(&group);
+				}
+
+				std::vector<ScanOutcome> found = ScanBlocked(scans, regions, aLimit);
+				std::copy(found.begin(), found.end(), results.begin() + first);
+			};
+
+			std::vector<std::thread> threads;
+
+			for (uint64_t i = 1; i < threadCount; i++)
+			{
+				threads.emplace_back(worker, i);
+			}
+
+			worker(0);
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			return results;
+		}
+
+	private:
+		static constexpr uint32_t MAGIC     = 0x4453544D; /* "MTSD" */
+		static constexpr uint32_t VERSION   = 2;
+		static constexpr uint32_t NO_STRING = UINT32_MAX;
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t WCharSize;
+			uint32_t Reserved;
+			uint64_t GroupCount;
+			uint64_t ScanCount;
+			uint64_t InstructionCount;
+			uint64_t ByteCount;
+			uint64_t StringSize;
+		};
+
+		struct GroupRecord
+		{
+			uint32_t Name;
+			uint32_t FirstScan;
+			uint32_t ScanCount;
+			uint32_t Reserved;
+		};
+
+		struct ScanRecord
+		{
+			uint32_t FirstByte;
+			uint32_t ByteCount;
+			uint32_t FirstInstruction;
+			uint32_t InstructionCount;
+		};
+
+		struct InstructionRecord
+		{
+			uint32_t Operation;
+			uint32_t String;
+			int64_t  Value;
+		};
+
+		const GroupRecord*       Groups           = nullptr;
+		const ScanRecord*        Scans            = nullptr;
+		const InstructionRecord* Instructions     = nullptr;
+		const Byte*              Bytes            = nullptr;
+		const char*              Strings          = nullptr;
+		uint64_t                 GroupCount       = 0;
+		uint64_t                 ScanCount        = 0;
+		uint64_t                 InstructionCount = 0;
+		uint64_t                 ByteCount        = 0;
+		uint64_t                 StringSize       = 0;
+		MappedFile               File;
+
+		static constexpr uint64_t Align(uint64_t aSize)
+		{
+			return (aSize + 7) & ~(uint64_t)7;
+		}
+
+		inline bool Fail()
+		{
+			*this = SignatureDatabase();
+			return false;
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// IsString:
+		/// 	Returns true if a zero-terminated string of aCharSize units starts at the offset.
+		///----------------------------------------------------------------------------------------------------
+		inline bool IsString(uint64_t aOffset, uint64_t aCharSize, uint64_t aAlign) const
+		{
+			if (aOffset % aAlign != 0) { return false; }
+
+			for (uint64_t i = aOffset; i + aCharSize <= this->StringSize; i += aCharSize)
+			{
+				bool zero = true;
+
+				for (uint64_t k = 0; k < aCharSize; k++)
+				{
+					zero = zero && this->Strings[i + k] == 0;
+				}
+
+				if (zero) { return true; }
+			}
+
+			return false;
+		}
+
+		inline PatternScan GetPatternScan(uint64_t aScan) const
+		{
+			const ScanRecord& record = this->Scans[aScan];
+
+			PatternScan scan{ Pattern() };
+
+			/* Refer to the mapped bytes, nothing is copied. */
+			scan.Assembly = Pattern::View(this->Bytes + record.FirstByte, record.ByteCount);
+
+			for (uint32_t i = 0; i < record.InstructionCount; i++)
+			{
+				const InstructionRecord& inst = this->Instructions[record.FirstInstruction + i];
+
+				/* Load checked the operation, and that comparisons and only they have a string. */
+				EOperation op = (EOperation)inst.Operation;
+
+				if (op == EOperation::strcmp)
+				{
+					scan.Instructions[i] = Instruction(op, this->Strings + inst.String);
+				}
+				else if (op == EOperation::wcscmp)
+				{
+					scan.Instructions[i] = Instruction(op, (const wchar_t*)(this->Strings + inst.String));
+				}
+				else
+				{
+					scan.Instructions[i] = Instruction(op, inst.Value);
+				}
+			}
+
+			scan.Count = record.InstructionCount;
+
+			return scan;
+		}
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// SignatureConstraints Struct
+	///----------------------------------------------------------------------------------------------------
+	struct SignatureConstraints
+	{
+		uint64_t           MaxLength             = 64;
+		bool               WildcardRelative      = true;    /* rel32 branch offsets and RIP-relative displacements */
+		bool               WildcardDisplacements = false;   /* other memory displacements, e.g. struct offsets */
+		bool               WildcardImmediates    = false;   /* immediates of 2 bytes or more */
+		bool               AllowReferences       = true;    /* sign referencing code if the address can't be signed */
+		uint64_t           MaxReferences         = 16;      /* referencing sites to try */
+		const SuffixIndex* Index                 = nullptr; /* optional index of the module, for uniqueness checks */
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// GeneratedSignature Struct
+	/// 	A pattern unique within its module, plus the Offset and Follow needed to reach the address.
+	///----------------------------------------------------------------------------------------------------
+	struct GeneratedSignature
+	{
+		std::string Pattern;
+		int64_t     Offset   = 0;
+		bool        IsFollow = false;
+		PBYTE       Match    = nullptr; /* where the pattern matches */
+
+		inline explicit operator bool() const
+		{
+			return !this->Pattern.empty();
+		}
+
+		///----------------------------------------------------------------------------------------------------
+		/// ToScan:
+		/// 	Returns the PatternScan resolving the signature.
+		///----------------------------------------------------------------------------------------------------
+		inline PatternScan ToScan() const
+		{
+			memtools::Pattern pattern(this->Pattern.c_str());
+
+			if (this->IsFollow) { return PatternScan(pattern, memtools::Offset(this->Offset), memtools::Follow()); }
+			if (this->Offset)   { return PatternScan(pattern, memtools::Offset(this->Offset)); }
+
+			return PatternScan(pattern);
+		}
+	};
+
+	namespace signature
+	{
+		///----------------------------------------------------------------------------------------------------
+		/// Format:
+		/// 	Formats bytes as a pattern string, e.g. "48 8B 05 ? ? ? ?".
+		///----------------------------------------------------------------------------------------------------
+		inline std::string Format(const std::vector<Byte>& aBytes)
+		{
+			static const char s_Hex[] = "0123456789ABCDEF";
+
+			std::string result;
+
+			for (const Byte& b : aBytes)
+			{
+				if (!result.empty()) { result += ' '; }
+
+				if (b.IsWildcard)
+				{
+					result += '?';
+				}
+				else if (b.Mask == 0xF0 || b.Mask == 0x0F)
+				{
+					result += b.Mask == 0xF0 ? s_Hex[b.Value >> 4] : '?';
+					result += b.Mask == 0x0F ? s_Hex[b.Value & 15] : '?';
+				}
+				else
+				{
+					result += s_Hex[b.Value >> 4];
+					result += s_Hex[b.Value & 15];
+
+					if (!b.IsExact())
+					{
+						result += '&';
+						result += s_Hex[b.Mask >> 4];
+						result += s_Hex[b.Mask & 15];
+					}
+				}
+			}
 
-	///----------------------------------------------------------------------------------------------------
-	/// PushAddr:
-	/// 	Stores the current address on the address stack.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction PushAddr() { return Instruction(EOperation::pushaddr); }
+			return result;
+		}
 
-	///----------------------------------------------------------------------------------------------------
-	/// PopAddr:
-	/// 	Restores the last address on the address stack and removes it.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction PopAddr() { return Instruction(EOperation::popaddr); }
+		///----------------------------------------------------------------------------------------------------
+		/// Matches:
+		/// 	Compares bytes [aFrom, aTo) of a pattern at a candidate, within the candidate's section.
+		///----------------------------------------------------------------------------------------------------
+		inline bool Matches(const std::vector<Byte>& aBytes, uint64_t aFrom, uint64_t aTo, PBYTE aCandidate, PBYTE aSectionEnd)
+		{
+			if (aCandidate + aTo > aSectionEnd) { return false; }
 
-	///----------------------------------------------------------------------------------------------------
-	/// AdvWcard:
-	/// 	Adds an offset to the current offset, so that the address will be at the next set of wildcards.
-	/// 	Pass aSets for how many amount of sets should be skipped.
-	///----------------------------------------------------------------------------------------------------
-	constexpr Instruction AdvWcard(int64_t aSets = 1) { return Instruction(EOperation::advwcard, aSets > 1 ? aSets : 1); }
+			for (uint64_t i = aFrom; i < aTo; i++)
+			{
+				if (!aBytes[i].Matches(aCandidate[i])) { return false; }
+			}
 
-	///----------------------------------------------------------------------------------------------------
-	/// PatternScan Struct
-	///----------------------------------------------------------------------------------------------------
-	struct PatternScan
-	{
-		Pattern                                         Assembly;
-		std::array<Instruction, MAX_INSTRUCTION_LENGTH> Instructions = {};
-		std::size_t                                     Count        = 0;
+			return true;
+		}
 
 		///----------------------------------------------------------------------------------------------------
-		/// ctor
+		/// Image Struct
+		/// 	An image to sign in, with its code sections and the start of the code to sign.
 		///----------------------------------------------------------------------------------------------------
-		template<typename... Instrs>
-		constexpr PatternScan(Pattern aASM, Instrs... instrs)
-			: Assembly(aASM)
-			, Instructions{ instrs... }
-			, Count(sizeof...(Instrs))
+		struct Image
 		{
-			static_assert(sizeof...(Instrs) <= MAX_INSTRUCTION_LENGTH, "Too many instructions for PatternScan.");
-		}
+			PBYTE              Base;
+			std::vector<Range> Sections;
+			PBYTE              Start;
+		};
 
-		template<typename... Instrs>
-		constexpr PatternScan(PatternScan aScan, Instrs... instrs)
-			: Assembly(aScan.Assembly)
-			, Instructions(aScan.Instructions)
-			, Count(aScan.Count + sizeof...(Instrs))
+		///----------------------------------------------------------------------------------------------------
+		/// CollectCandidates:
+		/// 	Returns all matches of the pattern in the sections of an image, with their section end.
+		///----------------------------------------------------------------------------------------------------
+		inline std::vector<std::pair<PBYTE, PBYTE>> CollectCandidates(const std::vector<Byte>& aBytes, const Image& aImage)
 		{
-			std::size_t idx = aScan.Count;
-			for (const Instruction instr : {instrs...})
+			std::vector<std::pair<PBYTE, PBYTE>> candidates;
+
+			Pattern pattern = Pattern::View(aBytes.data(), aBytes.size());
+
+			for (const Range& section : aImage.Sections)
 			{
-				if (idx > MAX_INSTRUCTION_LENGTH)
-					throw "Too many instructions for PatternScan.";
-				Instructions[idx++] = instr;
+				PBYTE    base   = aImage.Base + section.Offset;
+				uint64_t offset = 0;
+
+				while (PBYTE match = FindPattern(pattern, base, section.Size, offset))
+				{
+					candidates.emplace_back(match, base + section.Size);
+					offset = (uint64_t)(match - base) + 1;
+				}
 			}
+
+			return candidates;
 		}
 
 		///----------------------------------------------------------------------------------------------------
-		/// Scan:
-		/// 	Scans for the memory pattern and returns its pointer if found.
+		/// SignAt:
+		/// 	Grows a pattern instruction by instruction from the start of every image, until it is
+		/// 	unique within each image. Instructions are merged across images: bytes that differ become
+		/// 	wildcards, differing instruction lengths end the pattern. Candidates are collected in one
+		/// 	pass per image (in parallel for several images) for the first instruction and then only
+		/// 	filtered, or counted with the suffix index if given. Returns an empty string on failure.
 		///----------------------------------------------------------------------------------------------------
-		template <typename T = void*>
-		inline T Scan() const
+		inline std::string SignAt(const std::vector<Image>& aImages, const SignatureConstraints& aConstraints)
 		{
-			if (this->Assembly.Size == 0) { return nullptr; }
+			if (aImages.empty()) { return std::string(); }
 
-			void* resultAddr = nullptr;
+			uint64_t maxLength = aConstraints.MaxLength;
+			bool     useIndex  = aConstraints.Index && aImages.size() == 1;
 
-			PBYTE addr = 0;
+			std::vector<Byte>                                 bytes;
+			std::vector<std::vector<std::pair<PBYTE, PBYTE>>> candidates(aImages.size()); /* match, end of its section */
+			bool                                              collected = false;
 
-#ifdef ENABLE_PATTERN_CACHING
-			struct PatternMatch
+			auto isUniqueAt = [&](uint64_t aLength)
 			{
-				memtools::Pattern Pattern;
-				void*             Address;
+				if (useIndex)
+				{
+					Pattern pattern = Pattern::View(bytes.data(), aLength);
+
+					return aConstraints.Index->Count(pattern, 2) == 1;
+				}
+
+				for (const auto& imageCandidates : candidates)
+				{
+					uint64_t count = 0;
+
+					for (const auto& candidate : imageCandidates)
+					{
+						if (Matches(bytes, 0, aLength, candidate.first, candidate.second) && ++count > 1) { return false; }
+					}
+
+					if (count != 1) { return false; }
+				}
+
+				return true;
 			};
 
-			static std::mutex                s_PatternMatchMutex;
-			static std::vector<PatternMatch> s_PatternMatchStore;
+			std::vector<PBYTE> positions;
+			std::vector<PBYTE> ends; /* end of the section containing the start, the pattern can't grow past it */
 
+			for (const Image& image : aImages)
 			{
-				const std::lock_guard<std::mutex> lock(s_PatternMatchMutex);
-				auto it = std::find_if(s_PatternMatchStore.begin(), s_PatternMatchStore.end(), [this](const PatternMatch& match)
+				auto section = std::find_if(image.Sections.begin(), image.Sections.end(), [&](const Range& aSection)
 				{
-					return match.Pattern == this->Assembly;
+					return image.Start >= image.Base + aSection.Offset && image.Start < image.Base + aSection.Offset + aSection.Size;
 				});
 
-				/* If stored, start from stored address. */
-				if (it != s_PatternMatchStore.end())
-				{
-					addr = (PBYTE)it->Address;
-				}
-			}
-#endif
+				if (section == image.Sections.end()) { return std::string(); }
 
-			MEMORY_BASIC_INFORMATION mbi{};
+				positions.push_back(image.Start);
+				ends.push_back(image.Base + section->Offset + section->Size);
+			}
 
-			while (resultAddr == nullptr)
+			while (bytes.size() < maxLength)
 			{
-				/* If virtual query fails, stop scanning. */
-				if (!VirtualQuery(addr, &mbi, sizeof(mbi)))
-				{
-					break;
-				}
+				uint64_t previous = bytes.size();
+				uint8_t  length   = 0;
 
-				/* Advance query address into the next page. */
-				addr += mbi.RegionSize;
+				std::vector<Byte> merged;
 
-				/* Sanity check: Page is smaller than bytes to match against. */
-				if (this->Assembly.Size > mbi.RegionSize)
+				for (size_t n = 0; n < aImages.size(); n++)
 				{
-					continue;
-				}
+					DecodedInstruction decoded;
+					PBYTE              pos = positions[n];
 
-				/* Skip uncommitted pages. */
-				if (mbi.State != MEM_COMMIT)
-				{
-					continue;
+					if (pos >= ends[n] || !DecodeInstruction(pos, std::min<uint64_t>(15, ends[n] - pos), decoded)) { return std::string(); }
+
+					/* The images no longer align, the pattern can't grow. */
+					if (n > 0 && decoded.Length != length) { return std::string(); }
+
+					length = decoded.Length;
+					merged.resize(length, Byte{ false, 0 });
+
+					for (uint8_t i = 0; i < decoded.Length; i++)
+					{
+						bool inDisp = decoded.DispSize && i >= decoded.DispOffset && i < decoded.DispOffset + decoded.DispSize;
+						bool inImm  = decoded.ImmSize && i >= decoded.ImmOffset && i < decoded.ImmOffset + decoded.ImmSize;
+
+						bool wildcard = false;
+						wildcard |= inDisp && decoded.IsRipRelative && aConstraints.WildcardRelative;
+						wildcard |= inDisp && !decoded.IsRipRelative && aConstraints.WildcardDisplacements;
+						wildcard |= inImm && decoded.IsBranch && decoded.ImmSize == 4 && aConstraints.WildcardRelative;
+						wildcard |= inImm && !decoded.IsBranch && decoded.ImmSize >= 2 && aConstraints.WildcardImmediates;
+						wildcard |= n > 0 && merged[i].Value != pos[i];
+
+						if (wildcard || merged[i].IsWildcard) { merged[i] = Byte{ true }; }
+						else                                  { merged[i].Value = pos[i]; }
+					}
+
+					positions[n] += decoded.Length;
 				}
 
-				/* Skip pages without read permission. */
-				if (!(mbi.Protect == PAGE_EXECUTE_READ || mbi.Protect == PAGE_EXECUTE_READWRITE))
+				for (uint8_t i = 0; i < length && bytes.size() < maxLength; i++)
 				{
-					continue;
+					bytes.push_back(merged[i]);
 				}
 
-				PBYTE base = (PBYTE)mbi.BaseAddress;
-				uint64_t end = mbi.RegionSize - this->Assembly.Size; // ensure not going out of bounds
+				/* Shortest prefix of the last instruction that may be tried once unique. */
+				uint64_t floor = previous;
 
-				bool isMatch = false;
+				/* Patterns need a concrete byte to be matched efficiently. */
+				if (std::all_of(bytes.begin(), bytes.end(), [](const Byte& b) { return b.IsWildcard; })) { continue; }
 
-				for (uint64_t i = 0; i < end; i++)
+				if (!useIndex)
 				{
-					isMatch = this->Assembly == &base[i];
-
-					if (isMatch)
+					if (!collected)
 					{
-#ifdef ENABLE_PATTERN_CACHING
+						if (aImages.size() == 1)
 						{
-							const std::lock_guard<std::mutex> lock(s_PatternMatchMutex);
-							auto it = std::find_if(s_PatternMatchStore.begin(), s_PatternMatchStore.end(), [this](const PatternMatch& match)
-							{
-								return match.Pattern == this->Assembly;
-							});
+							candidates[0] = CollectCandidates(bytes, aImages[0]);
+						}
+						else
+						{
+							std::vector<std::thread> workers;
 
-							/* If stored, start from stort address. */
-							if (it == s_PatternMatchStore.end())
+							for (size_t n = 0; n < aImages.size(); n++)
 							{
-								s_PatternMatchStore.push_back(PatternMatch{ this->Assembly, base + i });
+								workers.emplace_back([&, n]() { candidates[n] = CollectCandidates(bytes, aImages[n]); });
 							}
+
+							for (std::thread& worker : workers) { worker.join(); }
 						}
-#endif
 
-						resultAddr = base + i;
+						/* Candidates only match the whole instruction, it can't be shortened. */
+						collected = true;
+						floor = bytes.size() - 1;
+					}
+					else
+					{
+						/* Keep candidates matching up to the previous instruction, for shrinking below. */
+						for (auto& imageCandidates : candidates)
+						{
+							imageCandidates.erase(std::remove_if(imageCandidates.begin(), imageCandidates.end(), [&](const std::pair<PBYTE, PBYTE>& aCandidate)
+							{
+								return !Matches(bytes, 0, previous, aCandidate.first, aCandidate.second);
+							}), imageCandidates.end());
+						}
+					}
+				}
 
-						uint32_t instructionsFailed = 0;
+				if (!isUniqueAt(bytes.size())) { continue; }
 
-						std::vector<void*> addrStore{};
+				/* Unique, find the shortest prefix within the last instruction. */
+				uint64_t size = bytes.size();
 
-						/* Track offsets for wildcard advancing. */
-						int64_t offsetFromMatch = 0;
+				while (size - 1 > floor && isUniqueAt(size - 1)) { size--; }
+				while (size > 1 && bytes[size - 1].IsWildcard) { size--; }
 
-						for (const Instruction& inst : this->Instructions)
-						{
-							EOperation op = inst.Operation;
+				bytes.resize(size);
 
-							switch (op)
-							{
-								case EOperation::offset:
-								{
-									offsetFromMatch += inst.Value;
-									resultAddr = (PBYTE)resultAddr + inst.Value;
-									break;
-								}
-								case EOperation::follow:
-								{
-									resultAddr = FollowRelativeAddress((PBYTE)resultAddr);
-									break;
-								}
-								case EOperation::strcmp:
-								{
-									instructionsFailed += strcmp((const char*)FollowRelativeAddress(resultAddr), inst.String) == 0 ? 0 : 1;
-									break;
-								}
-								case EOperation::wcscmp:
-								{
-									instructionsFailed += wcscmp((const wchar_t*)FollowRelativeAddress(resultAddr), inst.WString) == 0 ? 0 : 1;
-									break;
-								}
-								case EOperation::cmpi8:
-								{
-									instructionsFailed += *((int8_t*)resultAddr) == (int8_t)inst.Value ? 0 : 1;
-									break;
-								}
-								case EOperation::cmpi16:
-								{
-									instructionsFailed += *((int16_t*)resultAddr) == (int16_t)inst.Value ? 0 : 1;
-									break;
-								}
-								case EOperation::cmpi32:
-								{
-									instructionsFailed += *((int32_t*)resultAddr) == (int32_t)inst.Value ? 0 : 1;
-									break;
-								}
-								case EOperation::cmpi64:
-								{
-									instructionsFailed += *((int64_t*)resultAddr) == (int64_t)inst.Value ? 0 : 1;
-									break;
-								}
-								case EOperation::pushaddr:
-								{
-									addrStore.push_back(resultAddr);
-									break;
-								}
-								case EOperation::popaddr:
-								{
-									resultAddr = addrStore.back();
-									addrStore.pop_back();
-									break;
-								}
-								case EOperation::advwcard:
-								{
-									/* Advance as many sets as in the parameter. */
-									for (int64_t i = 0; i < inst.Value; i++)
-									{
-										bool wasAtWildcard = this->Assembly.Bytes[offsetFromMatch].IsWildcard;
-										bool foundWildcard = false;
-
-										while (offsetFromMatch < (int64_t)this->Assembly.Size)
-										{
-											if (wasAtWildcard && this->Assembly.Bytes[offsetFromMatch].IsWildcard)
-											{
-												offsetFromMatch++;
-											}
-											else if (!wasAtWildcard && this->Assembly.Bytes[offsetFromMatch].IsWildcard)
-											{
-												break;
-											}
-											else
-											{
-												offsetFromMatch++;
-												wasAtWildcard = false;
-											}
-										}
-									}
-
-									resultAddr = base + i + offsetFromMatch;
+				return Format(bytes);
+			}
 
-									break;
-								}
-								default:
-									break;
-							}
+			return std::string();
+		}
 
-							if (instructionsFailed)
-							{
-								/* interrupt if any failed */
-								resultAddr = nullptr;
-								break;
-							}
-						}
+		///----------------------------------------------------------------------------------------------------
+		/// FindInstructionStart:
+		/// 	Returns the start of the instruction whose RIP-relative displacement is at aDisp.
+		///----------------------------------------------------------------------------------------------------
+		inline PBYTE FindInstructionStart(PBYTE aDisp, EXrefKind aKind)
+		{
+			if (aKind == EXrefKind::call || aKind == EXrefKind::jmp) { return aDisp - 1; }
+			if (aKind == EXrefKind::jcc)                             { return aDisp - 2; }
 
-						if (!instructionsFailed)
-						{
-							/* the instructions were all executed, we interrupt the byte iteration */
-							break;
-						}
-					}
+			/* ModRM is directly before the displacement, prefixes and opcode before that. */
+			for (uint8_t back = 2; back <= 7; back++)
+			{
+				DecodedInstruction decoded;
+
+				if (DecodeInstruction(aDisp - back, 15, decoded) && decoded.IsRipRelative && decoded.DispOffset == back)
+				{
+					return aDisp - back;
 				}
 			}
 
-			return (T)resultAddr;
+			return nullptr;
 		}
-	};
+	}
 
 	///----------------------------------------------------------------------------------------------------
-	/// FallbackScan Struct
+	/// GenerateSignature:
+	/// 	Generates the shortest pattern, grown from aAddress by whole instructions and unique within
+	/// 	the module containing it. Relocatable fields are wildcarded as set in the constraints.
+	/// 	If no unique pattern starts at the address, code referencing it is signed instead,
+	/// 	resolved through Offset and Follow. Returns an empty signature on failure.
 	///----------------------------------------------------------------------------------------------------
-	struct FallbackScan
+	inline GeneratedSignature GenerateSignature(const void* aAddress, const SignatureConstraints& aConstraints = SignatureConstraints())
 	{
-		std::vector<PatternScan> Scans;
+		GeneratedSignature result;
 
-		///----------------------------------------------------------------------------------------------------
-		/// ctor
-		///----------------------------------------------------------------------------------------------------
-		inline FallbackScan(std::initializer_list<PatternScan> aScans)
+		PBYTE module = GetModuleBaseFromAddress(aAddress);
+
+		if (!module) { return result; }
+
+		std::vector<Range> sections = GetExecutableSections(module);
+
+		bool isCode = std::any_of(sections.begin(), sections.end(), [&](const Range& aSection)
 		{
-			for (const PatternScan& scan : aScans)
+			return (PBYTE)aAddress >= module + aSection.Offset && (PBYTE)aAddress < module + aSection.Offset + aSection.Size;
+		});
+
+		if (isCode)
+		{
+			result.Pattern = signature::SignAt({ signature::Image{ module, sections, (PBYTE)aAddress } }, aConstraints);
+
+			if (result)
 			{
-				this->Scans.push_back(scan);
+				result.Match = (PBYTE)aAddress;
+				return result;
 			}
 		}
 
-		///----------------------------------------------------------------------------------------------------
-		/// Scan:
-		/// 	Performs the datascans sequentially, returning if one succeeds. Otherwise returns nullptr.
-		///----------------------------------------------------------------------------------------------------
-		template <typename T = void*>
-		inline T Scan() const
+		if (!aConstraints.AllowReferences) { return GeneratedSignature(); }
+
+		std::vector<Xref> xrefs;
+
+		for (const Range& section : sections)
 		{
-			for (const PatternScan& scan : this->Scans)
+			XrefScan(aAddress).ScanRange(module + section.Offset, section.Size, xrefs);
+		}
+
+		uint64_t tried = 0;
+
+		for (const Xref& xref : xrefs)
+		{
+			if (tried++ >= aConstraints.MaxReferences) { break; }
+
+			PBYTE start = signature::FindInstructionStart(xref.Address, xref.Kind);
+
+			if (!start) { continue; }
+
+			std::string pattern = signature::SignAt({ signature::Image{ module, sections, start } }, aConstraints);
+
+			/* Prefer the shortest pattern over all referencing sites. */
+			if (!pattern.empty() && (!result || pattern.size() < result.Pattern.size()))
 			{
-				void* result = scan.Scan();
+				result.Pattern  = pattern;
+				result.Offset   = xref.Address - start;
+				result.IsFollow = true;
+				result.Match    = start;
+			}
+		}
 
-				if (result)
-				{
-					return (T)result;
-				}
+		return result;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// SignatureSource Struct
+	/// 	The same code located in one image, e.g. one build of a game.
+	///----------------------------------------------------------------------------------------------------
+	struct SignatureSource
+	{
+		const void* Image    = nullptr;
+		uint64_t    Size     = 0;     /* size of the image data */
+		uint64_t    Offset   = 0;     /* offset of the code in the image data */
+		bool        IsMapped = false; /* false for files read from disk, see RvaToFileOffset */
+	};
+
+	///----------------------------------------------------------------------------------------------------
+	/// RvaToFileOffset:
+	/// 	Translates a relative virtual address of a PE or ELF64 file of aSize bytes to its offset in
+	/// 	the file. Returns UINT64_MAX if the address is not backed by the file.
+	///----------------------------------------------------------------------------------------------------
+	inline uint64_t RvaToFileOffset(const void* aImage, uint64_t aSize, uint64_t aRva)
+	{
+		const std::vector<Range> mapped = GetExecutableSections(aImage, true, aSize);
+		const std::vector<Range> file   = GetExecutableSections(aImage, false, aSize);
+
+		for (size_t i = 0; i < mapped.size() && i < file.size(); i++)
+		{
+			if (aRva >= mapped[i].Offset && aRva < mapped[i].Offset + file[i].Size)
+			{
+				return file[i].Offset + (aRva - mapped[i].Offset);
 			}
+		}
 
-			return (T)nullptr;
+		return UINT64_MAX;
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// GenerateCommonSignature:
+	/// 	Generates the shortest pattern matching the located code in every image, and unique within
+	/// 	the code sections of each. Bytes differing between images are wildcarded, in addition to
+	/// 	the relocatable fields set in the constraints. Candidates are computed in parallel across
+	/// 	images. Returns an empty signature on failure.
+	///----------------------------------------------------------------------------------------------------
+	inline GeneratedSignature GenerateCommonSignature(const std::vector<SignatureSource>& aSources, const SignatureConstraints& aConstraints = SignatureConstraints())
+	{
+		GeneratedSignature result;
+
+		std::vector<signature::Image> images;
+
+		for (const SignatureSource& source : aSources)
+		{
+			if (!source.Image || source.Size == 0) { return result; }
+
+			signature::Image image{ (PBYTE)source.Image, GetExecutableSections(source.Image, source.IsMapped, source.Size), (PBYTE)source.Image + source.Offset };
+
+			/* Clip sections to the image data, file sections already are. */
+			for (Range& section : image.Sections)
+			{
+				section.Size = section.Offset < source.Size ? std::min(section.Size, source.Size - section.Offset) : 0;
+			}
+
+			bool inCode = std::any_of(image.Sections.begin(), image.Sections.end(), [&](const Range& aSection)
+			{
+				return source.Offset >= aSection.Offset && source.Offset + 15 <= aSection.Offset + aSection.Size;
+			});
+
+			if (!inCode) { return result; }
+
+			images.push_back(std::move(image));
 		}
-	};
 
+		SignatureConstraints constraints = aConstraints;
+		constraints.Index = nullptr;
+
+		result.Pattern = signature::SignAt(images, constraints);
+
+		return result;
+	}
+
+#ifdef _WIN32
 	///----------------------------------------------------------------------------------------------------
 	/// Patch Struct
 	///----------------------------------------------------------------------------------------------------
@@ -725,6 +8083,7 @@ namespace memtools
 			delete this->OriginalBytes;
 		}
 	};
+#endif
 }
 
 #endif
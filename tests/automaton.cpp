@@ -0,0 +1,368 @@
+///----------------------------------------------------------------------------------------------------
+/// Extended pattern tests
+/// 	PatternAutomaton::Find against a reference matcher on random buffers and random patterns with
+/// 	gaps, byte sets and nested alternations, the reset of the DFA state cache, and the rejection
+/// 	of invalid patterns.
+///
+/// 	g++ -std=c++17 -I.. automaton.cpp -o automaton && ./automaton
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+using memtools::PatternAutomaton;
+using memtools::PBYTE;
+
+/* Few distinct values, so random patterns match often. */
+static const uint8_t s_Alphabet[] = { 0x00, 0x41, 0x82, 0xC3 };
+
+///----------------------------------------------------------------------------------------------------
+/// Node Struct
+/// 	Reference form of an extended pattern, rendered to text for PatternAutomaton.
+///----------------------------------------------------------------------------------------------------
+struct Node
+{
+	enum class EKind
+	{
+		byte,        /* Value & Mask, Mask 0 for a wildcard */
+		set,         /* any of Values */
+		gap,         /* Min to Max bytes */
+		sequence,
+		alternation
+	};
+
+	EKind                Kind = EKind::sequence;
+	uint8_t              Value = 0;
+	uint8_t              Mask  = 0xFF;
+	std::vector<uint8_t> Values;
+	uint64_t             Min = 0;
+	uint64_t             Max = 0;
+	std::vector<Node>    Children;
+
+	std::string Render() const
+	{
+		char buffer[32];
+
+		switch (this->Kind)
+		{
+			case EKind::byte:
+			{
+				if (this->Mask == 0)         { return "??"; }
+				if (this->Mask == 0xF0)      { snprintf(buffer, sizeof(buffer), "%X?", this->Value >> 4); }
+				else if (this->Mask == 0x0F) { snprintf(buffer, sizeof(buffer), "?%X", this->Value & 0xF); }
+				else                         { snprintf(buffer, sizeof(buffer), "%02X", this->Value); }
+
+				return buffer;
+			}
+			case EKind::set:
+			{
+				std::string text = "{";
+
+				for (size_t i = 0; i < this->Values.size(); i++)
+				{
+					snprintf(buffer, sizeof(buffer), "%s%02X", i ? "|" : "", this->Values[i]);
+					text += buffer;
+				}
+
+				return text + "}";
+			}
+			case EKind::gap:
+			{
+				if (this->Min == this->Max) { snprintf(buffer, sizeof(buffer), "[%llu]", (unsigned long long)this->Min); }
+				else                        { snprintf(buffer, sizeof(buffer), "[%llu-%llu]", (unsigned long long)this->Min, (unsigned long long)this->Max); }
+
+				return buffer;
+			}
+			case EKind::sequence:
+			{
+				std::string text;
+
+				for (const Node& child : this->Children) { text += (text.empty() ? "" : " ") + child.Render(); }
+
+				return text;
+			}
+			case EKind::alternation:
+			default:
+			{
+				std::string text = "(";
+
+				for (size_t i = 0; i < this->Children.size(); i++) { text += (i ? " | " : "") + this->Children[i].Render(); }
+
+				return text + ")";
+			}
+		}
+	}
+
+	///----------------------------------------------------------------------------------------------------
+	/// Ends:
+	/// 	Returns every offset a match of the node starting at aPosition can end at, by backtracking.
+	///----------------------------------------------------------------------------------------------------
+	std::set<uint64_t> Ends(const std::vector<uint8_t>& aBuffer, uint64_t aPosition) const
+	{
+		std::set<uint64_t> ends;
+
+		switch (this->Kind)
+		{
+			case EKind::byte:
+			{
+				if (aPosition < aBuffer.size() && (aBuffer[aPosition] & this->Mask) == (this->Value & this->Mask)) { ends.insert(aPosition + 1); }
+				break;
+			}
+			case EKind::set:
+			{
+				if (aPosition < aBuffer.size() && std::find(this->Values.begin(), this->Values.end(), aBuffer[aPosition]) != this->Values.end()) { ends.insert(aPosition + 1); }
+				break;
+			}
+			case EKind::gap:
+			{
+				for (uint64_t k = this->Min; k <= this->Max && aPosition + k <= aBuffer.size(); k++) { ends.insert(aPosition + k); }
+				break;
+			}
+			case EKind::sequence:
+			{
+				ends.insert(aPosition);
+
+				for (const Node& child : this->Children)
+				{
+					std::set<uint64_t> next;
+
+					for (uint64_t end : ends)
+					{
+						std::set<uint64_t> childEnds = child.Ends(aBuffer, end);
+						next.insert(childEnds.begin(), childEnds.end());
+					}
+
+					ends.swap(next);
+				}
+
+				break;
+			}
+			case EKind::alternation:
+			{
+				for (const Node& child : this->Children)
+				{
+					std::set<uint64_t> childEnds = child.Ends(aBuffer, aPosition);
+					ends.insert(childEnds.begin(), childEnds.end());
+				}
+
+				break;
+			}
+		}
+
+		return ends;
+	}
+};
+
+///----------------------------------------------------------------------------------------------------
+/// FindReference:
+/// 	Returns the offset of the leftmost match at or after aStart, or UINT64_MAX.
+///----------------------------------------------------------------------------------------------------
+static uint64_t FindReference(const Node& aPattern, const std::vector<uint8_t>& aBuffer, uint64_t aStart)
+{
+	for (uint64_t offset = aStart; offset < aBuffer.size(); offset++)
+	{
+		if (!aPattern.Ends(aBuffer, offset).empty()) { return offset; }
+	}
+
+	return UINT64_MAX;
+}
+
+static Node RandomByte(std::mt19937& aRng)
+{
+	Node node;
+
+	switch (aRng() % 5)
+	{
+		case 0:
+		{
+			node.Kind = Node::EKind::set;
+
+			for (uint8_t value : s_Alphabet) { if (aRng() % 2) { node.Values.push_back(value); } }
+			if (node.Values.empty()) { node.Values.push_back(s_Alphabet[aRng() % 4]); }
+
+			return node;
+		}
+		case 1:  node.Mask = 0xF0; break;
+		case 2:  node.Mask = 0x0F; break;
+		case 3:  node.Mask = 0;    break;
+		default: break;
+	}
+
+	node.Kind  = Node::EKind::byte;
+	node.Value = (uint8_t)(s_Alphabet[aRng() % 4] & node.Mask);
+
+	return node;
+}
+
+///----------------------------------------------------------------------------------------------------
+/// RandomSequence:
+/// 	Returns a sequence starting with a byte, so it never matches the empty string.
+///----------------------------------------------------------------------------------------------------
+static Node RandomSequence(std::mt19937& aRng, int aDepth)
+{
+	Node sequence;
+	sequence.Children.push_back(RandomByte(aRng));
+
+	for (uint32_t i = aRng() % 4; i > 0; i--)
+	{
+		uint32_t kind = aRng() % 6;
+
+		if (kind == 0)
+		{
+			Node gap;
+			gap.Kind = Node::EKind::gap;
+			gap.Min  = aRng() % 3;
+			gap.Max  = gap.Min + aRng() % 3;
+
+			/* [0] alone matches nothing, it is only valid as a range. */
+			if (gap.Max == 0) { gap.Max = 1; }
+
+			sequence.Children.push_back(gap);
+		}
+		else if (kind == 1 && aDepth < 3)
+		{
+			Node alternation;
+			alternation.Kind = Node::EKind::alternation;
+
+			for (uint32_t k = 2 + aRng() % 2; k > 0; k--) { alternation.Children.push_back(RandomSequence(aRng, aDepth + 1)); }
+
+			sequence.Children.push_back(alternation);
+		}
+		else
+		{
+			sequence.Children.push_back(RandomByte(aRng));
+		}
+	}
+
+	return sequence;
+}
+
+int main()
+{
+	std::mt19937 rng(44);
+
+	/* Find against the reference, restarting after every match with one cache per pattern. */
+	for (int iteration = 0; iteration < 1500; iteration++)
+	{
+		Node pattern = RandomSequence(rng, 0);
+
+		/* Top-level alternations now and then. */
+		if (iteration % 5 == 0)
+		{
+			Node alternation;
+			alternation.Kind = Node::EKind::alternation;
+			alternation.Children.push_back(pattern);
+			alternation.Children.push_back(RandomSequence(rng, 1));
+
+			pattern = alternation;
+		}
+
+		std::string text = pattern.Render();
+
+		/* Without the outer parentheses of a top-level alternation. */
+		if (iteration % 5 == 0 && iteration % 2 == 0) { text = text.substr(1, text.size() - 2); }
+
+		std::vector<uint8_t> buffer(1 + rng() % 200);
+
+		for (uint8_t& b : buffer) { b = s_Alphabet[rng() % 4]; }
+
+		PatternAutomaton        automaton(text);
+		PatternAutomaton::Cache cache;
+
+		uint64_t start = 0;
+
+		while (true)
+		{
+			uint64_t expected = FindReference(pattern, buffer, start);
+			PBYTE    found    = automaton.Find(buffer.data(), buffer.size(), start, cache);
+			uint64_t actual   = found ? (uint64_t)(found - buffer.data()) : UINT64_MAX;
+
+			if (actual != expected)
+			{
+				CHECK(false, "'%s' from %llu: found %lld, expected %lld", text.c_str(), (unsigned long long)start, (long long)actual, (long long)expected);
+				break;
+			}
+
+			if (actual == UINT64_MAX) { break; }
+
+			start = actual + 1;
+		}
+	}
+
+	/* A byte 20 bytes before another tracks every recent 41 in the DFA state, far more than the
+	   cache holds. Results must stay the same across resets. */
+	{
+		Node pattern;
+		pattern.Children.resize(3);
+		pattern.Children[0].Kind  = Node::EKind::byte;
+		pattern.Children[0].Value = 0x41;
+		pattern.Children[1].Kind  = Node::EKind::gap;
+		pattern.Children[1].Min   = pattern.Children[1].Max = 20;
+		pattern.Children[2].Kind  = Node::EKind::byte;
+		pattern.Children[2].Value = 0xC3;
+
+		std::vector<uint8_t> buffer(64 * 1024);
+
+		for (uint8_t& b : buffer) { b = s_Alphabet[rng() % 4]; }
+
+		PatternAutomaton        automaton(pattern.Render());
+		PatternAutomaton::Cache cache;
+
+		uint64_t start   = 0;
+		uint64_t matches = 0;
+		size_t   largest = 0;
+		bool     reset   = false;
+
+		while (true)
+		{
+			size_t before = cache.Sets.size();
+
+			uint64_t expected = FindReference(pattern, buffer, start);
+			PBYTE    found    = automaton.Find(buffer.data(), buffer.size(), start, cache);
+			uint64_t actual   = found ? (uint64_t)(found - buffer.data()) : UINT64_MAX;
+
+			reset   = reset || cache.Sets.size() < before;
+			largest = std::max(largest, cache.Sets.size());
+
+			if (actual != expected)
+			{
+				CHECK(false, "cache reset: from %llu found %lld, expected %lld", (unsigned long long)start, (long long)actual, (long long)expected);
+				break;
+			}
+
+			if (actual == UINT64_MAX) { break; }
+
+			matches++;
+			start = actual + 1;
+		}
+
+		CHECK(reset, "the state cache was never reset, largest %zu states", largest);
+		CHECK(largest <= 4096, "the state cache grew to %zu states", largest);
+		CHECK(matches > 0, "no matches");
+	}
+
+	/* Invalid patterns. */
+	for (const char* invalid : { "", "(48|)", "(|48)", "48 |", "48 (8B|) 05", "[8-2]", "48 [8-2] 05", "(48 8B", "48 (8B|(05 0D)",
+		"48)", "{48|4C", "{}", "[4", "[4097]", "[0]", "48 GG" })
+	{
+		bool threw = false;
+
+		try { PatternAutomaton automaton(invalid); }
+		catch (const char*) { threw = true; }
+
+		CHECK(threw, "'%s' accepted", invalid);
+	}
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+///----------------------------------------------------------------------------------------------------
+/// Awaitable scan tests (C++20)
+/// 	co_await scan.Await() on the ThreadExecutor, the InlineExecutor and an executor that keeps
+/// 	using its own state after handing off the task.
+///
+/// 	g++ -std=c++20 -I.. await.cpp -o await -pthread && ./await
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <thread>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+#ifdef MEMTOOLS_HAS_COROUTINES
+///----------------------------------------------------------------------------------------------------
+/// Task Struct
+/// 	Fire-and-forget coroutine, its frame is destroyed as soon as it finishes.
+///----------------------------------------------------------------------------------------------------
+struct Task
+{
+	struct promise_type
+	{
+		Task get_return_object() { return Task(); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+struct Outcome
+{
+	void*           Result;
+	std::thread::id Thread;
+};
+
+static Task AwaitScan(const memtools::PatternScan& aScan, memtools::Executor aExecutor, std::promise<Outcome>& aDone)
+{
+	void* result = co_await aScan.Await(aExecutor);
+
+	aDone.set_value(Outcome{ result, std::this_thread::get_id() });
+}
+
+int main()
+{
+	/* syscall, present in the C library. */
+	const memtools::PatternScan scan("0F 05 48 3D");
+
+	void* expected = scan.Scan();
+
+	CHECK(expected != nullptr, "pattern not found");
+
+	/* Inline: the coroutine continues on the calling thread, after the executor returned. */
+	{
+		bool inExecutor = false;
+
+		memtools::Executor inlineExecutor = [&inExecutor](std::function<void()> aTask)
+		{
+			inExecutor = true;
+			memtools::InlineExecutor()(std::move(aTask));
+			inExecutor = false;
+		};
+
+		std::promise<Outcome> done;
+		std::future<Outcome>  outcome = done.get_future();
+
+		bool resumedInExecutor = true;
+
+		[&]() -> Task
+		{
+			co_await scan.Await(inlineExecutor);
+			resumedInExecutor = inExecutor;
+			done.set_value(Outcome{ nullptr, std::this_thread::get_id() });
+		}();
+
+		CHECK(outcome.wait_for(std::chrono::seconds(0)) == std::future_status::ready, "inline await did not complete synchronously");
+		CHECK(!resumedInExecutor, "inline await resumed inside the executor");
+		CHECK(outcome.get().Thread == std::this_thread::get_id(), "inline await resumed on another thread");
+
+		std::promise<Outcome> plain;
+		AwaitScan(scan, memtools::InlineExecutor(), plain);
+
+		CHECK(plain.get_future().get().Result == expected, "inline await returned a different result");
+	}
+
+	/* Thread: the coroutine resumes on the scan's thread, many times to hit both orders. */
+	for (int i = 0; i < 200; i++)
+	{
+		std::promise<Outcome> done;
+		std::future<Outcome>  outcome = done.get_future();
+
+		AwaitScan(scan, memtools::ThreadExecutor(), done);
+
+		Outcome result = outcome.get();
+
+		CHECK(result.Result == expected, "thread await %d returned %p, expected %p", i, result.Result, expected);
+	}
+
+	/* The executor uses its captured state after handing off the task, while the coroutine may
+	   already have finished and freed its frame. Run under ASan to catch a use-after-free. */
+	for (int i = 0; i < 50; i++)
+	{
+		std::promise<Outcome> done;
+		std::future<Outcome>  outcome = done.get_future();
+
+		std::vector<int> state(16);
+
+		memtools::Executor lateExecutor = [state](std::function<void()> aTask) mutable
+		{
+			std::thread(std::move(aTask)).detach();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			state.push_back((int)state.size());
+		};
+
+		AwaitScan(scan, lateExecutor, done);
+
+		CHECK(outcome.get().Result == expected, "late executor await %d returned a different result", i);
+	}
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}
+#else
+int main()
+{
+	printf("%s: coroutines not supported, build with -std=c++20\n", __FILE__);
+	return 0;
+}
+#endif
@@ -0,0 +1,227 @@
+///----------------------------------------------------------------------------------------------------
+/// Signature database tests
+/// 	Write -> Load round trip of SignatureDatabase, and rejection of truncated and corrupted files
+/// 	and of instructions that can't be executed.
+///
+/// 	g++ -std=c++17 -I.. database.cpp -o database -pthread && ./database
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+#include <cwchar>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static const char* s_Path      = "memtools_test.db";
+static const char* s_Truncated = "memtools_test_truncated.db";
+
+static std::vector<uint8_t> ReadFile(const char* aPath)
+{
+	std::vector<uint8_t> data;
+
+	if (FILE* file = fopen(aPath, "rb"))
+	{
+		uint8_t buffer[4096];
+		size_t  read;
+
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) { data.insert(data.end(), buffer, buffer + read); }
+
+		fclose(file);
+	}
+
+	return data;
+}
+
+static void WriteFile(const char* aPath, const uint8_t* aData, size_t aSize)
+{
+	FILE* file = fopen(aPath, "wb");
+
+	if (aSize) { fwrite(aData, 1, aSize, file); }
+
+	fclose(file);
+}
+
+///----------------------------------------------------------------------------------------------------
+/// SameScan:
+/// 	Compares the pattern and the instructions of two scans.
+///----------------------------------------------------------------------------------------------------
+static bool SameScan(const memtools::PatternScan& aLeft, const memtools::PatternScan& aRight)
+{
+	if (aLeft.Assembly != aRight.Assembly || aLeft.Count != aRight.Count) { return false; }
+
+	for (size_t i = 0; i < aLeft.Count; i++)
+	{
+		const memtools::Instruction& left  = aLeft.Instructions[i];
+		const memtools::Instruction& right = aRight.Instructions[i];
+
+		if (left.Operation != right.Operation || left.Value != right.Value) { return false; }
+		if ((left.String == nullptr) != (right.String == nullptr) || (left.String && strcmp(left.String, right.String))) { return false; }
+		if ((left.WString == nullptr) != (right.WString == nullptr) || (left.WString && wcscmp(left.WString, right.WString))) { return false; }
+	}
+
+	return true;
+}
+
+int main()
+{
+	using namespace memtools;
+
+	PatternScan offset("0F 1F 84 00 DE AD BE EF", Offset(4), CmpI8((int8_t)0xDE));
+	PatternScan nibbles("0F 1F 84 00 C? FE ?? B8&F8");
+	PatternScan strings("DE AD DE AD 11 22 33 ?? ??", Strcmp("hello"), Wcscmp(L"wide"));
+	PatternScan missing("DE AD DE AD 11 22 33 44 56");
+
+	/* Longer than the inline storage of a Pattern. */
+	PatternScan longScan("48 89 5C 24 08 48 89 74 24 10 57 48 83 EC 20 48 8B F9 48 8B 0D ? ? ? ? E8 ? ? ? ? 48 8B D8 48 85 C0 74 1F");
+
+	std::vector<SignatureDatabase::Entry> entries
+	{
+		{ "zeta",    offset },
+		{ "alpha",   FallbackScan{ missing, nibbles } },
+		{ "strings", strings },
+		{ "long",    longScan },
+	};
+
+	CHECK(SignatureDatabase::Write(s_Path, entries), "Write failed");
+
+	/* Round trip. */
+	{
+		SignatureDatabase db;
+
+		CHECK(db.Load(s_Path), "Load failed");
+		CHECK(db.GetCount() == entries.size(), "count %llu", (unsigned long long)db.GetCount());
+		CHECK(db.Find("nope") == UINT64_MAX, "found a missing name");
+
+		for (const SignatureDatabase::Entry& entry : entries)
+		{
+			uint64_t group = db.Find(entry.Name.c_str());
+
+			if (group == UINT64_MAX)
+			{
+				CHECK(false, "%s not found", entry.Name.c_str());
+				continue;
+			}
+
+			const char* name = db.GetName(group);
+
+			CHECK(name && strcmp(name, entry.Name.c_str()) == 0, "%s named %s", entry.Name.c_str(), name ? name : "(null)");
+
+			FallbackScan loaded = db.GetScan(group);
+
+			CHECK(loaded.Scans.size() == entry.Scans.Scans.size(), "%s has %zu scans", entry.Name.c_str(), loaded.Scans.size());
+
+			for (size_t i = 0; i < loaded.Scans.size() && i < entry.Scans.Scans.size(); i++)
+			{
+				CHECK(SameScan(loaded.Scans[i], entry.Scans.Scans[i]), "%s scan %zu differs", entry.Name.c_str(), i);
+			}
+		}
+
+		/* Loaded scans find the same matches. */
+		uint8_t buffer[64]{};
+		uint8_t code[] = { 0x0F, 0x1F, 0x84, 0x00, 0xCA, 0xFE, 0x00, 0xBE, 0x0F, 0x1F, 0x84, 0x00, 0xDE, 0xAD, 0xBE, 0xEF };
+		memcpy(buffer + 20, code, sizeof(code));
+
+		for (const char* name : { "zeta", "alpha" })
+		{
+			FallbackScan original = entries[name[0] == 'z' ? 0 : 1].Scans;
+			FallbackScan loaded   = db.GetScan(db.Find(name));
+
+			void* expected = nullptr;
+			void* actual   = nullptr;
+
+			for (const PatternScan& scan : original.Scans) { if ((expected = scan.ScanRange(buffer, sizeof(buffer)))) { break; } }
+			for (const PatternScan& scan : loaded.Scans)   { if ((actual = scan.ScanRange(buffer, sizeof(buffer))))   { break; } }
+
+			CHECK(expected != nullptr && actual == expected, "%s matched %p, expected %p", name, actual, expected);
+		}
+	}
+
+	std::vector<uint8_t> file = ReadFile(s_Path);
+
+	CHECK(!file.empty(), "empty database file");
+
+	/* Every truncation is rejected. */
+	for (size_t size = 0; size < file.size(); size++)
+	{
+		WriteFile(s_Truncated, file.data(), size);
+
+		SignatureDatabase db;
+
+		CHECK(!db.Load(s_Truncated), "loaded a file truncated to %zu of %zu bytes", size, file.size());
+		CHECK(!db.IsValid(), "valid after failing to load %zu bytes", size);
+	}
+
+	/* A wrong magic, and trailing bytes. */
+	{
+		std::vector<uint8_t> corrupt = file;
+		corrupt[0] ^= 0xFF;
+		WriteFile(s_Truncated, corrupt.data(), corrupt.size());
+
+		SignatureDatabase db;
+		CHECK(!db.Load(s_Truncated), "loaded a file with a wrong magic");
+
+		std::vector<uint8_t> longer = file;
+		longer.resize(file.size() + 8, 0);
+		WriteFile(s_Truncated, longer.data(), longer.size());
+
+		CHECK(!db.Load(s_Truncated), "loaded a file with trailing bytes");
+	}
+
+	/* Instructions that can't be executed. */
+	{
+		PatternScan scan("DE AD", PushAddr(), Offset(1), PopAddr(), Strcmp("x"), CmpI8(1));
+
+		CHECK(SignatureDatabase::Write(s_Path, { { "scan", scan } }), "Write failed");
+
+		std::vector<uint8_t> valid = ReadFile(s_Path);
+
+		/* Header (56 bytes), one group and one scan record (16 bytes each), then the instruction
+		   records: uint32_t Operation, uint32_t String, int64_t Value. */
+		auto field = [](std::vector<uint8_t>& aFile, uint64_t aInstruction, uint64_t aField) { return (uint32_t*)(aFile.data() + 88 + aInstruction * 16 + aField * 4); };
+
+		CHECK(*field(valid, 0, 0) == (uint32_t)EOperation::pushaddr && *field(valid, 3, 0) == (uint32_t)EOperation::strcmp, "unexpected layout");
+
+		struct Corruption
+		{
+			const char* What;
+			uint64_t    Instruction;
+			uint64_t    Field;
+			uint32_t    Value;
+		};
+
+		const Corruption corruptions[] =
+		{
+			{ "popaddr without pushaddr",    0, 0, (uint32_t)EOperation::offset },
+			{ "unknown operation",           1, 0, (uint32_t)EOperation::capfollow + 1 },
+			{ "strcmp without a string",     3, 1, UINT32_MAX },
+			{ "string of a cmpi8",           3, 0, (uint32_t)EOperation::cmpi8 },
+			{ "wcscmp without a string",     4, 0, (uint32_t)EOperation::wcscmp },
+		};
+
+		for (const Corruption& corruption : corruptions)
+		{
+			std::vector<uint8_t> corrupt = valid;
+			*field(corrupt, corruption.Instruction, corruption.Field) = corruption.Value;
+			WriteFile(s_Truncated, corrupt.data(), corrupt.size());
+
+			SignatureDatabase db;
+			CHECK(!db.Load(s_Truncated), "loaded a database with a %s", corruption.What);
+		}
+
+		SignatureDatabase db;
+		CHECK(db.Load(s_Path), "Load of the uncorrupted database failed");
+
+		CHECK(!SignatureDatabase::Write(s_Truncated, { { "null", PatternScan("DE AD", Strcmp(nullptr)) } }), "wrote a strcmp without a string");
+	}
+
+	remove(s_Path);
+	remove(s_Truncated);
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}
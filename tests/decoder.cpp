@@ -0,0 +1,152 @@
+///----------------------------------------------------------------------------------------------------
+/// Decoder tests
+/// 	Lengths and field offsets of DecodeInstruction for a table of known encodings, checked
+/// 	against objdump.
+///
+/// 	g++ -std=c++17 -I.. decoder.cpp -o decoder && ./decoder
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+struct Encoding
+{
+	const char* Bytes;
+	uint8_t     Length;
+	uint8_t     DispOffset;
+	uint8_t     DispSize;
+	uint8_t     ImmOffset;
+	uint8_t     ImmSize;
+	bool        IsRipRelative;
+	bool        IsBranch;
+};
+
+static const Encoding s_Encodings[] =
+{
+	/* bytes                                 len disp     imm      rip    branch */
+	{ "90",                                   1, 0, 0,    0, 0,    false, false }, /* nop */
+	{ "C3",                                   1, 0, 0,    0, 0,    false, false }, /* ret */
+	{ "55",                                   1, 0, 0,    0, 0,    false, false }, /* push rbp */
+	{ "48 89 E5",                             3, 0, 0,    0, 0,    false, false }, /* mov rbp, rsp */
+	{ "48 83 EC 20",                          4, 0, 0,    3, 1,    false, false }, /* sub rsp, 0x20 */
+	{ "48 81 EC 00 01 00 00",                 7, 0, 0,    3, 4,    false, false }, /* sub rsp, 0x100 */
+	{ "48 8B 05 78 56 34 12",                 7, 3, 4,    0, 0,    true,  false }, /* mov rax, [rip + d32] */
+	{ "48 8D 0D 78 56 34 12",                 7, 3, 4,    0, 0,    true,  false }, /* lea rcx, [rip + d32] */
+	{ "E8 78 56 34 12",                       5, 0, 0,    1, 4,    false, true  }, /* call rel32 */
+	{ "E9 78 56 34 12",                       5, 0, 0,    1, 4,    false, true  }, /* jmp rel32 */
+	{ "EB 10",                                2, 0, 0,    1, 1,    false, true  }, /* jmp rel8 */
+	{ "74 05",                                2, 0, 0,    1, 1,    false, true  }, /* je rel8 */
+	{ "0F 84 78 56 34 12",                    6, 0, 0,    2, 4,    false, true  }, /* je rel32 */
+	{ "48 B8 88 77 66 55 44 33 22 11",       10, 0, 0,    2, 8,    false, false }, /* movabs rax, imm64 */
+	{ "B8 78 56 34 12",                       5, 0, 0,    1, 4,    false, false }, /* mov eax, imm32 */
+	{ "66 B8 34 12",                          4, 0, 0,    2, 2,    false, false }, /* mov ax, imm16 */
+	{ "48 89 5C 24 08",                       5, 4, 1,    0, 0,    false, false }, /* mov [rsp + 8], rbx */
+	{ "8B 84 24 00 01 00 00",                 7, 3, 4,    0, 0,    false, false }, /* mov eax, [rsp + 0x100] */
+	{ "0F 1F 44 00 00",                       5, 4, 1,    0, 0,    false, false }, /* nop dword [rax + rax] */
+	{ "66 0F 1F 84 00 00 00 00 00",           9, 5, 4,    0, 0,    false, false }, /* nop word [rax + rax] */
+	{ "66 2E 0F 1F 84 00 00 00 00 00",       10, 6, 4,    0, 0,    false, false }, /* cs nop word [rax + rax] */
+	{ "C5 F8 77",                             3, 0, 0,    0, 0,    false, false }, /* vzeroupper */
+	{ "C4 E2 79 18 05 78 56 34 12",           9, 5, 4,    0, 0,    true,  false }, /* vbroadcastss xmm0, [rip + d32] */
+	{ "62 F1 7C 48 10 00",                    6, 0, 0,    0, 0,    false, false }, /* vmovups zmm0, [rax] */
+	{ "F3 0F 1E FA",                          4, 0, 0,    0, 0,    false, false }, /* endbr64 */
+	{ "0F 05",                                2, 0, 0,    0, 0,    false, false }, /* syscall */
+	{ "C2 08 00",                             3, 0, 0,    1, 2,    false, false }, /* ret 8 */
+	{ "C8 10 00 00",                          4, 0, 0,    1, 3,    false, false }, /* enter 0x10, 0 */
+	{ "66 0F 3A 0F C1 08",                    6, 0, 0,    5, 1,    false, false }, /* palignr xmm0, xmm1, 8 */
+	{ "F0 48 0F B1 0A",                       5, 0, 0,    0, 0,    false, false }, /* lock cmpxchg [rdx], rcx */
+	{ "41 FF D0",                             3, 0, 0,    0, 0,    false, false }, /* call r8 */
+	{ "FF 25 78 56 34 12",                    6, 2, 4,    0, 0,    true,  false }, /* jmp [rip + d32] */
+	{ "C7 05 78 56 34 12 01 00 00 00",       10, 2, 4,    6, 4,    true,  false }, /* mov dword [rip + d32], imm32 */
+	{ "66 C7 05 78 56 34 12 34 12",           9, 3, 4,    7, 2,    true,  false }, /* mov word [rip + d32], imm16 */
+	{ "48 C7 C0 78 56 34 12",                 7, 0, 0,    3, 4,    false, false }, /* mov rax, imm32 */
+	{ "F6 C1 01",                             3, 0, 0,    2, 1,    false, false }, /* test cl, 1 */
+	{ "F7 C1 78 56 34 12",                    6, 0, 0,    2, 4,    false, false }, /* test ecx, imm32 */
+	{ "F6 D1",                                2, 0, 0,    0, 0,    false, false }, /* not cl */
+	{ "48 A1 88 77 66 55 44 33 22 11",       10, 0, 0,    2, 8,    false, false }, /* movabs rax, [moffs64] */
+	{ "0F B6 04 08",                          4, 0, 0,    0, 0,    false, false }, /* movzx eax, byte [rax + rcx] */
+};
+
+///----------------------------------------------------------------------------------------------------
+/// ToBytes:
+/// 	Returns the bytes of a hex string such as "48 8B 05".
+///----------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> ToBytes(const char* aText)
+{
+	std::vector<uint8_t> bytes;
+	memtools::Pattern    pattern;
+
+	memtools::ParsePattern(aText, pattern);
+
+	for (uint64_t i = 0; i < pattern.Size; i++) { bytes.push_back(pattern.Data()[i].Value); }
+
+	return bytes;
+}
+
+int main()
+{
+	for (const Encoding& encoding : s_Encodings)
+	{
+		std::vector<uint8_t> bytes = ToBytes(encoding.Bytes);
+
+		/* Trailing bytes must not be consumed. */
+		bytes.resize(bytes.size() + 15, 0xCC);
+
+		memtools::DecodedInstruction decoded;
+
+		if (!memtools::DecodeInstruction(bytes.data(), bytes.size(), decoded))
+		{
+			CHECK(false, "%s: not decoded", encoding.Bytes);
+			continue;
+		}
+
+		CHECK(decoded.Length == encoding.Length, "%s: length %u, expected %u", encoding.Bytes, decoded.Length, encoding.Length);
+		CHECK(decoded.IsRipRelative == encoding.IsRipRelative, "%s: rip-relative %d", encoding.Bytes, decoded.IsRipRelative);
+		CHECK(decoded.IsBranch == encoding.IsBranch, "%s: branch %d", encoding.Bytes, decoded.IsBranch);
+
+		if (encoding.DispSize)
+		{
+			CHECK(decoded.DispOffset == encoding.DispOffset && decoded.DispSize == encoding.DispSize,
+				"%s: displacement %u+%u, expected %u+%u", encoding.Bytes, decoded.DispOffset, decoded.DispSize, encoding.DispOffset, encoding.DispSize);
+		}
+		else
+		{
+			CHECK(decoded.DispSize == 0, "%s: unexpected displacement of %u bytes", encoding.Bytes, decoded.DispSize);
+		}
+
+		if (encoding.ImmSize)
+		{
+			CHECK(decoded.ImmOffset == encoding.ImmOffset && decoded.ImmSize == encoding.ImmSize,
+				"%s: immediate %u+%u, expected %u+%u", encoding.Bytes, decoded.ImmOffset, decoded.ImmSize, encoding.ImmOffset, encoding.ImmSize);
+		}
+		else
+		{
+			CHECK(decoded.ImmSize == 0, "%s: unexpected immediate of %u bytes", encoding.Bytes, decoded.ImmSize);
+		}
+
+		/* The same instruction cut short by a byte doesn't decode. */
+		memtools::DecodedInstruction truncated;
+
+		CHECK(!memtools::DecodeInstruction(bytes.data(), encoding.Length - 1, truncated), "%s: decoded with %u bytes", encoding.Bytes, encoding.Length - 1);
+	}
+
+	/* Opcodes invalid in 64-bit mode. */
+	for (const char* invalid : { "06", "27", "60", "D4 0A", "EA 00 00 00 00 00 00" })
+	{
+		std::vector<uint8_t> bytes = ToBytes(invalid);
+		bytes.resize(16, 0);
+
+		memtools::DecodedInstruction decoded;
+
+		CHECK(!memtools::DecodeInstruction(bytes.data(), bytes.size(), decoded), "%s: decoded as %u bytes", invalid, decoded.Length);
+	}
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+///----------------------------------------------------------------------------------------------------
+/// Nibble and bitmask matching tests
+/// 	Byte::Matches for every byte value, and FindPattern (scalar and AVX-512BW if supported)
+/// 	against a reference matcher on random buffers and patterns.
+///
+/// 	g++ -std=c++17 -I.. matching.cpp -o matching && ./matching
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+using memtools::Byte;
+using memtools::PBYTE;
+
+///----------------------------------------------------------------------------------------------------
+/// FindReference:
+/// 	Returns the first match at or after aStart, byte by byte.
+///----------------------------------------------------------------------------------------------------
+static PBYTE FindReference(const std::vector<Byte>& aBytes, PBYTE aBase, uint64_t aSize, uint64_t aStart)
+{
+	for (uint64_t offset = aStart; offset + aBytes.size() <= aSize; offset++)
+	{
+		bool matches = true;
+
+		for (uint64_t i = 0; i < aBytes.size() && matches; i++)
+		{
+			matches = aBytes[i].IsWildcard || (aBase[offset + i] & aBytes[i].Mask) == (aBytes[i].Value & aBytes[i].Mask);
+		}
+
+		if (matches) { return aBase + offset; }
+	}
+
+	return nullptr;
+}
+
+int main()
+{
+	/* Parsed forms. */
+	{
+		memtools::Pattern pattern("4? ?5 B8&F8 ?? 00&00");
+
+		const Byte* bytes = pattern.Data();
+
+		CHECK(pattern.Size == 5, "size %llu", (unsigned long long)pattern.Size);
+		CHECK(!bytes[0].IsWildcard && bytes[0].Value == 0x40 && bytes[0].Mask == 0xF0, "4?: %02X&%02X", bytes[0].Value, bytes[0].Mask);
+		CHECK(!bytes[1].IsWildcard && bytes[1].Value == 0x05 && bytes[1].Mask == 0x0F, "?5: %02X&%02X", bytes[1].Value, bytes[1].Mask);
+		CHECK(!bytes[2].IsWildcard && bytes[2].Value == 0xB8 && bytes[2].Mask == 0xF8, "B8&F8: %02X&%02X", bytes[2].Value, bytes[2].Mask);
+		CHECK(bytes[3].IsWildcard, "?? is not a wildcard");
+		CHECK(bytes[4].IsWildcard, "an empty mask is not a wildcard");
+	}
+
+	/* Every value against every byte. */
+	for (uint32_t mask : { 0xF0u, 0x0Fu, 0xF8u, 0x01u, 0x80u, 0x5Au, 0xFFu })
+	{
+		for (uint32_t value = 0; value < 256; value++)
+		{
+			Byte byte{ false, (uint8_t)value, (uint8_t)mask };
+
+			for (uint32_t input = 0; input < 256; input++)
+			{
+				bool expected = (input & mask) == (value & mask);
+
+				if (byte.Matches((uint8_t)input) != expected)
+				{
+					CHECK(false, "%02X&%02X against %02X", value, mask, input);
+					break;
+				}
+			}
+		}
+	}
+
+	/* FindPattern against the reference, with matches at region ends. */
+	std::mt19937 rng(7);
+
+	bool hasAVX512 = memtools::SupportsAVX512BW();
+
+	for (int iteration = 0; iteration < 2000; iteration++)
+	{
+		/* Few distinct values, so partial masks match often. */
+		std::vector<uint8_t> buffer(1 + rng() % 300);
+
+		for (uint8_t& b : buffer) { b = (uint8_t)(rng() % 4 * 0x41); }
+
+		std::vector<Byte> bytes(1 + rng() % 8);
+
+		for (Byte& b : bytes)
+		{
+			uint8_t value = (uint8_t)(rng() % 4 * 0x41);
+
+			switch (rng() % 5)
+			{
+				case 0:  b = Byte{ false, value };                 break;
+				case 1:  b = Byte{ false, value, 0xF0 };           break;
+				case 2:  b = Byte{ false, value, 0x0F };           break;
+				case 3:  b = Byte{ false, value, (uint8_t)rng() }; break;
+				default: b = Byte{ true };                         break;
+			}
+		}
+
+		if (bytes[0].IsWildcard) { bytes[0] = Byte{ false, 0x41, 0xF0 }; }
+
+		memtools::Pattern pattern(bytes.data(), bytes.size());
+
+		/* Plant a match at the very end of the buffer now and then. */
+		if (iteration % 4 == 0 && bytes.size() <= buffer.size())
+		{
+			for (uint64_t i = 0; i < bytes.size(); i++)
+			{
+				uint8_t& target = buffer[buffer.size() - bytes.size() + i];
+				target = (uint8_t)((target & ~bytes[i].Mask) | bytes[i].Value);
+			}
+		}
+
+		uint64_t start    = rng() % buffer.size();
+		PBYTE    expected = FindReference(bytes, buffer.data(), buffer.size(), start);
+		PBYTE    scalar   = memtools::FindPatternScalar(pattern, buffer.data(), buffer.size(), start);
+
+		CHECK(scalar == expected, "scalar: iteration %d found %p, expected %p", iteration, (void*)scalar, (void*)expected);
+
+#ifdef MEMTOOLS_HAS_AVX512
+		if (hasAVX512)
+		{
+			PBYTE vector = memtools::FindPatternAVX512(pattern, buffer.data(), buffer.size(), start);
+
+			CHECK(vector == expected, "AVX-512: iteration %d found %p, expected %p", iteration, (void*)vector, (void*)expected);
+		}
+#endif
+
+		PBYTE scanned = (PBYTE)memtools::PatternScan(pattern).ScanRange(buffer.data() + start, buffer.size() - start);
+
+		CHECK(scanned == expected, "PatternScan: iteration %d found %p, expected %p", iteration, (void*)scanned, (void*)expected);
+	}
+
+	printf("%s: %d failures%s\n", __FILE__, s_Failures, hasAVX512 ? "" : " (AVX-512BW not supported, scalar only)");
+
+	return s_Failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+///----------------------------------------------------------------------------------------------------
+/// Runtime parser tests
+/// 	Errors and positions reported by ParsePattern, and the bytes of the accepted styles.
+///
+/// 	g++ -std=c++17 -I.. parser.cpp -o parser && ./parser
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+using memtools::EParseError;
+
+struct Rejected
+{
+	const char* Text;
+	EParseError Error;
+	uint64_t    Position;
+};
+
+static const Rejected s_Rejected[] =
+{
+	{ "",                         EParseError::empty,            0 },
+	{ " \t, ",                    EParseError::empty,            0 },
+	{ "48 8B G5",                 EParseError::invalidCharacter, 6 },  /* G */
+	{ "48 8Z",                    EParseError::invalidCharacter, 4 },  /* Z */
+	{ "48 X",                     EParseError::invalidCharacter, 3 },  /* single character token */
+	{ "48 ?Z",                    EParseError::invalidCharacter, 4 },  /* Z after a nibble wildcard */
+	{ "48 8B0",                   EParseError::incompleteByte,   5 },  /* odd digit count */
+	{ "488B????0",                EParseError::incompleteByte,   8 },
+	{ "48 B8&F",                  EParseError::incompleteByte,   5 },  /* '&' without two mask digits */
+	{ "48 B8&FG",                 EParseError::incompleteByte,   5 },
+	{ "\\x48\\y8B",               EParseError::invalidCharacter, 4 },  /* not \x */
+	{ "\\x48\\x8",                EParseError::invalidCharacter, 4 },  /* cut short */
+	{ "\\x48\\x8G",               EParseError::incompleteByte,   4 },
+	{ "\\x48\\x8B\\x05 xxz",      EParseError::invalidMask,      15 }, /* z */
+	{ "\\x48\\x8B\\x05 xx?x",     EParseError::maskLength,       16 }, /* mask character without a byte */
+	{ "\\x48\\x8B\\x05 xx",       EParseError::maskLength,       15 }, /* end of the mask */
+};
+
+struct Accepted
+{
+	const char* Text;
+	const char* Formatted; /* as signature::Format prints the bytes */
+};
+
+static const Accepted s_Accepted[] =
+{
+	{ "48 8B 05 ? ? ? ? 01",             "48 8B 05 ? ? ? ? 01" },   /* IDA */
+	{ "48 8b ?? ?? 05",                  "48 8B ? ? 05" },          /* x64dbg, lowercase */
+	{ "488B????05",                      "48 8B ? ? 05" },          /* x64dbg, unseparated */
+	{ "4? ?5 B8&F8",                     "4? ?5 B8&F8" },           /* nibbles and bitmask */
+	{ "\"\\x48\\x8B\\x05\", \"xx?\"",    "48 8B ?" },               /* code-style with mask */
+	{ "\\x48\\x8B\\x05",                 "48 8B 05" },              /* code-style without mask */
+	{ " <48 8B> ",                       "48 8B" },                 /* significance brackets */
+};
+
+int main()
+{
+	for (const Rejected& rejected : s_Rejected)
+	{
+		memtools::Pattern pattern("90");
+
+		memtools::ParseResult result = memtools::ParsePattern(rejected.Text, pattern);
+
+		CHECK(!result, "'%s' parsed", rejected.Text);
+		CHECK(result.Error == rejected.Error, "'%s': error %d, expected %d", rejected.Text, (int)result.Error, (int)rejected.Error);
+		CHECK(result.Position == rejected.Position, "'%s': position %llu, expected %llu", rejected.Text, (unsigned long long)result.Position, (unsigned long long)rejected.Position);
+		CHECK(pattern.Size == 0, "'%s': pattern not cleared", rejected.Text);
+	}
+
+	for (const Accepted& accepted : s_Accepted)
+	{
+		memtools::Pattern pattern;
+
+		memtools::ParseResult result = memtools::ParsePattern(accepted.Text, pattern);
+
+		CHECK(result, "'%s': error %d at %llu", accepted.Text, (int)result.Error, (unsigned long long)result.Position);
+
+		std::string formatted = memtools::signature::Format(std::vector<memtools::Byte>(pattern.Data(), pattern.Data() + pattern.Size));
+
+		CHECK(formatted == accepted.Formatted, "'%s': parsed as '%s', expected '%s'", accepted.Text, formatted.c_str(), accepted.Formatted);
+	}
+
+	/* Byte array and mask pair. */
+	{
+		memtools::Pattern pattern;
+
+		CHECK(memtools::ParsePattern("\x48\x00\x05", "x?x", pattern) && pattern.Size == 3 && pattern.Data()[1].IsWildcard, "byte array and mask");
+
+		memtools::ParseResult result = memtools::ParsePattern("\x48\x00\x05", "xxz", pattern);
+
+		CHECK(result.Error == EParseError::invalidMask && result.Position == 2, "mask error %d at %llu", (int)result.Error, (unsigned long long)result.Position);
+		CHECK(memtools::ParsePattern("", "", pattern).Error == EParseError::empty, "empty mask");
+	}
+
+	/* The runtime parser agrees with the compile-time one. */
+	{
+		memtools::Pattern runtime;
+		memtools::ParsePattern("48 8B 05 ? ? ? ? 4? ?5 B8&F8", runtime);
+
+		CHECK(runtime == memtools::Pattern("48 8B 05 ? ? ? ? 4? ?5 B8&F8"), "runtime and compile-time patterns differ");
+	}
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}
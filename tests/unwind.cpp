@@ -0,0 +1,212 @@
+///----------------------------------------------------------------------------------------------------
+/// Unwind data tests
+/// 	FunctionTable of a generated PE32+ image with .pdata, as a file and mapped, and
+/// 	FunctionContaining against functions of this binary and the C library.
+///
+/// 	g++ -std=c++17 -I.. unwind.cpp -o unwind -pthread && ./unwind
+///----------------------------------------------------------------------------------------------------
+#include "memtools.h"
+
+#include <cstdio>
+#include <vector>
+
+static int s_Failures = 0;
+
+#define CHECK(aCondition, ...) \
+	do { if (!(aCondition)) { s_Failures++; printf("%s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+using memtools::FunctionTable;
+using memtools::PBYTE;
+
+/* RUNTIME_FUNCTION entries of the generated image, deliberately unsorted. The gap between
+   0x1040 and 0x1080 is padding. */
+static const uint32_t s_Pdata[][3] =
+{
+	{ 0x1080, 0x10A0, 0x3000 },
+	{ 0x1000, 0x1010, 0x3000 },
+	{ 0x1010, 0x1040, 0x3000 },
+	{ 0x10C0, 0x10C0, 0x3000 }, /* empty, skipped */
+};
+
+///----------------------------------------------------------------------------------------------------
+/// BuildImage:
+/// 	Returns a minimal PE32+ image with a .text and a .pdata section, in file layout if aIsMapped is
+/// 	false and in its loaded layout otherwise.
+///----------------------------------------------------------------------------------------------------
+static std::vector<uint8_t> BuildImage(bool aIsMapped)
+{
+	std::vector<uint8_t> image(aIsMapped ? 0x3000 : 0x800, 0);
+
+	auto write16 = [&image](uint64_t aOffset, uint16_t aValue) { memcpy(image.data() + aOffset, &aValue, sizeof(aValue)); };
+	auto write32 = [&image](uint64_t aOffset, uint32_t aValue) { memcpy(image.data() + aOffset, &aValue, sizeof(aValue)); };
+
+	const uint64_t nt        = 0x40;
+	const uint64_t optHeader = nt + 24;
+	const uint64_t sections  = optHeader + 240;
+
+	image[0] = 'M';
+	image[1] = 'Z';
+	write32(0x3C, (uint32_t)nt);
+
+	write32(nt, 0x00004550);         /* "PE\0\0" */
+	write16(nt + 4, 0x8664);         /* AMD64 */
+	write16(nt + 6, 2);              /* NumberOfSections */
+	write16(nt + 20, 240);           /* SizeOfOptionalHeader */
+
+	write16(optHeader, 0x20B);       /* PE32+ */
+	write32(optHeader + 108, 16);    /* NumberOfRvaAndSizes */
+	write32(optHeader + 112 + 3 * 8, 0x2000);
+	write32(optHeader + 112 + 3 * 8 + 4, (uint32_t)sizeof(s_Pdata));
+
+	/* name, VirtualSize, VirtualAddress, SizeOfRawData, PointerToRawData, Characteristics */
+	memcpy(image.data() + sections, ".text", 5);
+	write32(sections + 8, 0x100);
+	write32(sections + 12, 0x1000);
+	write32(sections + 16, 0x200);
+	write32(sections + 20, 0x400);
+	write32(sections + 36, 0x60000020);
+
+	memcpy(image.data() + sections + 40, ".pdata", 6);
+	write32(sections + 40 + 8, (uint32_t)sizeof(s_Pdata));
+	write32(sections + 40 + 12, 0x2000);
+	write32(sections + 40 + 16, 0x200);
+	write32(sections + 40 + 20, 0x600);
+	write32(sections + 40 + 36, 0x40000040);
+
+	memcpy(image.data() + (aIsMapped ? 0x2000 : 0x600), s_Pdata, sizeof(s_Pdata));
+
+	return image;
+}
+
+///----------------------------------------------------------------------------------------------------
+/// CheckPdata:
+/// 	Checks a table built from the generated image.
+///----------------------------------------------------------------------------------------------------
+static void CheckPdata(const FunctionTable& aTable, const char* aLayout)
+{
+	static const FunctionTable::Entry s_Expected[] = { { 0x1000, 0x1010 }, { 0x1010, 0x1040 }, { 0x1080, 0x10A0 } };
+
+	CHECK(aTable.Functions.size() == 3, "%s: %zu functions", aLayout, aTable.Functions.size());
+
+	for (size_t i = 0; i < aTable.Functions.size() && i < 3; i++)
+	{
+		CHECK(aTable.Functions[i].Begin == s_Expected[i].Begin && aTable.Functions[i].End == s_Expected[i].End,
+			"%s: function %zu is %llx-%llx", aLayout, i, (unsigned long long)aTable.Functions[i].Begin, (unsigned long long)aTable.Functions[i].End);
+	}
+
+	struct Lookup
+	{
+		uint64_t Offset;
+		uint64_t Begin; /* 0 if in no function */
+	};
+
+	static const Lookup s_Lookups[] =
+	{
+		{ 0x0FFF, 0 }, { 0x1000, 0x1000 }, { 0x100F, 0x1000 }, { 0x1010, 0x1010 }, { 0x103F, 0x1010 },
+		{ 0x1040, 0 }, { 0x107F, 0 }, { 0x1080, 0x1080 }, { 0x10A0, 0 }, { 0x10C0, 0 },
+	};
+
+	for (const Lookup& lookup : s_Lookups)
+	{
+		const FunctionTable::Entry* entry = aTable.Find(lookup.Offset);
+
+		CHECK((entry ? entry->Begin : 0) == lookup.Begin, "%s: %llx found in %llx, expected %llx", aLayout,
+			(unsigned long long)lookup.Offset, (unsigned long long)(entry ? entry->Begin : 0), (unsigned long long)lookup.Begin);
+	}
+
+	struct Span
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		bool     Crosses;
+	};
+
+	static const Span s_Spans[] =
+	{
+		{ 0x1000, 0x10, false }, /* one function */
+		{ 0x1008, 0x10, true  }, /* two adjacent functions */
+		{ 0x1040, 0x40, false }, /* padding */
+		{ 0x103C, 0x08, true  }, /* function into padding */
+		{ 0x1078, 0x30, true  }, /* padding, a whole function, padding */
+		{ 0x0F00, 0x50, false }, /* before the first function */
+		{ 0x1000, 0x00, false },
+	};
+
+	for (const Span& span : s_Spans)
+	{
+		CHECK(aTable.Crosses(span.Offset, span.Size) == span.Crosses, "%s: %llx+%llx crosses %d", aLayout,
+			(unsigned long long)span.Offset, (unsigned long long)span.Size, !span.Crosses);
+	}
+}
+
+static int Square(int aValue)
+{
+	return aValue * aValue;
+}
+
+static int SumOfSquares(int aCount)
+{
+	int sum = 0;
+
+	for (int i = 0; i < aCount; i++) { sum += Square(i); }
+
+	return sum;
+}
+
+int main()
+{
+	/* Generated PE32+ image, as a file and mapped. */
+	{
+		std::vector<uint8_t> file   = BuildImage(false);
+		std::vector<uint8_t> mapped = BuildImage(true);
+
+		FunctionTable fromFile(file.data(), false, file.size());
+		FunctionTable fromMapping(mapped.data());
+
+		CheckPdata(fromFile, "file");
+		CheckPdata(fromMapping, "mapped");
+
+		memtools::FunctionBounds bounds = fromMapping.Find(mapped.data() + 0x1020);
+
+		CHECK(bounds.Begin == mapped.data() + 0x1010 && bounds.End == mapped.data() + 0x1040, "mapped bounds %p-%p", (void*)bounds.Begin, (void*)bounds.End);
+		CHECK(!fromFile.Find(file.data() + 0x1020), "file tables have no base");
+
+		/* The directory past the end of the file. */
+		FunctionTable truncated(file.data(), false, 0x610);
+
+		CHECK(!truncated.IsValid(), "truncated .pdata parsed");
+	}
+
+	/* Functions of this binary and the C library. */
+	{
+		int (*functions[])(int) = { Square, SumOfSquares, abs };
+
+		for (int (*function)(int) : functions)
+		{
+			memtools::FunctionBounds bounds = memtools::FunctionContaining((const void*)function);
+
+			CHECK(bounds.Begin == (PBYTE)function && bounds.End > bounds.Begin, "function %p has bounds %p-%p", (void*)function, (void*)bounds.Begin, (void*)bounds.End);
+			CHECK(memtools::FunctionContaining((PBYTE)function + 1).Begin == bounds.Begin, "function %p not found from inside", (void*)function);
+		}
+
+		int local = SumOfSquares(4);
+
+		CHECK(!memtools::FunctionContaining(&local), "stack address in a function");
+
+		/* The same table from the file on disk. */
+		memtools::MappedFile file;
+
+		if (file.Open("/proc/self/exe"))
+		{
+			FunctionTable fromFile(file.Data, false, file.Size);
+			auto          loaded = FunctionTable::ForModule(memtools::GetModuleBase());
+
+			CHECK(loaded && fromFile.Functions.size() == loaded->Functions.size(), "%zu functions in the file, %zu loaded", fromFile.Functions.size(), loaded ? loaded->Functions.size() : 0);
+			CHECK(loaded && loaded == FunctionTable::ForModule(memtools::GetModuleBase()), "table not cached");
+		}
+	}
+
+	printf("%s: %d failures\n", __FILE__, s_Failures);
+
+	return s_Failures ? 1 : 0;
+}